@@ -32,13 +32,26 @@
 #define WAVEFRONT_OBJ
 
 #include <algorithm>
+#include <cmath>
+#include <clocale>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <string>
 #include <vector>
 #include <tuple>
 #include <map>
+#include <set>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <chrono>
+#include <atomic>
 #include <sys/stat.h>
 #include <cassert>
+#include <limits>
+#include <type_traits>
 
 namespace obj
 {
@@ -65,6 +78,8 @@ namespace obj
 
 	struct Normal : List<float> { };
 
+	struct Parameter : List<float> { };
+
 	struct Face
 	{
 		void clear();
@@ -89,11 +104,176 @@ namespace obj
 		List<int> vertex;
 	};
 
+	struct Range
+	{
+		size_t begin; //First face
+		size_t end;   //One past the last face
+	};
+
+	struct Bounds
+	{
+		Bounds();
+
+		void clear();
+
+		bool empty() const;
+
+		void insert(const float* xyz);
+
+		void centroid(float* xyz) const;
+
+		float  minimum[3];
+		float  maximum[3];
+		double sum[3];
+		size_t count; //Inserted points
+	};
+
+	struct Object
+	{
+		std::string         name;
+		std::vector<Range>  face;
+		std::vector<size_t> group;  //Groups used by the object, see Hierarchy::group
+		Bounds              bounds; //Vertices used by the faces, see LoadOption::extents
+	};
+
+	struct Group
+	{
+		std::string        name;
+		std::vector<Range> face;
+		Bounds             bounds;
+	};
+
+	struct Smoothing
+	{
+		int   id; //0 if smoothing is off
+		Range face;
+	};
+
+	struct Hierarchy
+	{
+		void clear();
+
+		void open(char type, const std::string& name, size_t face);
+
+		void close(size_t face);
+
+		void insert(const float* xyz);
+
+		void renumber(const std::vector<size_t>& kept); //Face ranges after faces were removed, kept[face] is the faces kept before face
+
+		const Object* findObject(const std::string& name) const;
+
+		const Group* findGroup(const std::string& name) const;
+
+		std::vector<Object>    object;
+		std::vector<Group>     group;
+		std::vector<Smoothing> smoothing;
+
+	private:
+
+		Object& current();
+
+		std::unordered_map<std::string, size_t> objectName;
+		std::unordered_map<std::string, size_t> groupName;
+		std::vector<size_t>                     activeGroup;
+		size_t                                  activeObject = 0;
+		int                                     activeSmoothing = 0;
+		size_t                                  begin = 0;
+	};
+
+	enum LoadOption
+	{
+		positions = 1 << 0, //v and f
+		textures  = 1 << 1, //vt and texture indices
+		normals   = 1 << 2, //vn and normal indices
+		metadata  = 1 << 3, //#, o, g and s
+		materials = 1 << 4, //mtllib and usemtl
+		elements  = 1 << 5, //l and p, without positions their vertex indices are neither resolved nor checked
+		extents   = 1 << 6, //Bounds of all vertices, and of each object and group
+		lenient   = 1 << 7, //Skip rows that fail to parse instead of failing the load
+		freeform  = 1 << 8, //vp, and curves, surfaces and other records kept as text
+		threaded  = 1 << 9, //Resolve and check indices on all hardware threads, needs -pthread
+		standard  = positions | textures | normals | metadata | materials | elements | freeform
+	};
+
+	enum ErrorCode
+	{
+		noError,
+		fileError,   //File could not be opened or read
+		emptyError,  //File has no content
+		numberError, //Malformed number in v, vt or vn
+		indexError,  //Malformed index in f, l or p
+		syntaxError, //Wrong number of values or unknown keyword
+		cancelError  //Load was cancelled, see Load::cancel
+	};
+
+	struct Error
+	{
+		Error();
+
+		void clear();
+
+		std::string message() const;
+
+		ErrorCode   code;
+		size_t      row;    //First row is 1, 0 if the error is not in a row
+		size_t      column; //First column is 1
+		std::string token;  //Offending text
+		std::string file;
+	};
+
+	struct Profile
+	{
+		Profile();
+
+		void clear();
+
+		void count(const char* line);
+
+		double open;     //Milliseconds in fopen and stat
+		double read;     //Milliseconds reading the file into memory
+		double document; //Milliseconds splitting memory into rows
+		double parse;    //Milliseconds parsing rows
+		double total;    //Milliseconds for the whole load
+
+		size_t bytes;    //File size
+		size_t rows;     //Rows in file
+		size_t memory;   //Bytes held when parsing ends: file, rows and lists
+
+		size_t counter[4]; //Change of Load::counter in open, read, document and parse
+
+		//Counters below are only updated with WAVEFRONT_OBJ_PROFILE defined
+
+		size_t vertex, texture, normal, face, line, point; //Rows per type
+		size_t material, information, other;               //Rows per type
+		size_t reallocations;                              //List storage growth
+	};
+
+	struct MemoryUsage
+	{
+		const char* name;
+		size_t      size;     //Bytes in use
+		size_t      capacity; //Bytes reserved
+	};
+
+	struct Progress
+	{
+		size_t bytes;     //Bytes consumed
+		size_t total;     //Bytes in file
+		size_t rows;      //Rows consumed, 0 if not counted
+		double elapsed;   //Milliseconds since start
+		double remaining; //Estimated milliseconds left
+	};
+
+	class Save;
+
 	class Load
 	{
+		friend class Save;
+
 	public:
 
-		explicit Load(bool triangulate = false);
+		explicit Load(bool triangulate = false, unsigned int options = standard);
 
 		~Load();
 
@@ -107,50 +287,123 @@ namespace obj
 
 		bool load(const std::string& path);
 
+		bool load(const std::string& path, const std::function<bool(const std::string&)>& select, bool compact = false);
+
+		bool load(const std::string& path, const std::set<std::string>& names, bool compact = false);
+
+		bool load(const char* data, size_t size); //Text already in memory, path is left empty
+
 		std::string mtllib();
 
 		std::vector<std::tuple<std::string, size_t>>& usemtl();
 
-		Vertex  vertex;  //Geometric vertices
-		Texture texture; //Texture vertices
-		Normal  normal;  //Normal vertices
+		std::vector<std::tuple<char, std::string, size_t>>& information();
+
+		std::vector<std::tuple<std::string, std::string, size_t>>& records(); //Free-form and other records: keyword, text and face
+
+		Vertex    vertex;    //Geometric vertices
+		Texture   texture;   //Texture vertices
+		Normal    normal;    //Normal vertices
+		Parameter parameter; //Parameter space vertices (vp)
 		Face    face;    //Indices face
 		Line    line;    //Indices line
 		Point   point;   //Indices point
 
+		Hierarchy hierarchy; //Objects, groups and smoothing groups as face ranges
+		Bounds    bounds;    //Geometric vertices, see LoadOption::extents
+
+		Profile                              profile;  //Stages and counters of the last load
+		std::function<void(const Profile&)> profiler; //Called after each load if set
+		std::function<size_t()>              counter;  //Optional running count sampled between stages, such as allocations
+
+		Error  error;   //Why the last load failed, or the first skipped row with LoadOption::lenient
+		size_t skipped; //Rows that failed to parse and faces, lines and points with an invalid index, skipped with LoadOption::lenient
+
+		std::function<void(const Progress&)> progress; //Called every interval rows while parsing, and when done
+		const std::atomic<bool>*             cancel;   //Checked every interval rows, the load fails with cancelError when true
+		size_t                               interval; //Rows between progress calls and cancel checks
+
 		void clear();
 
+		std::vector<MemoryUsage> memoryUsage() const;
+
+		void compact(bool exact = false); //Releases the growth slack of all lists, exact copies each list to a buffer of its size
+
 	private:
 
 		bool open(const std::string& path);
 
 		bool load(char** document, size_t rows);
 
+		bool parseRows(char** document, size_t rows);
+
+		bool filter(char type, const std::string& name);
+
+		void extent();
+
+		void extent(size_t corner);
+
 		void close();
 
+		bool report(size_t bytes, size_t rows, const std::chrono::steady_clock::time_point& start);
+
+		void checkpoint(bool& changed);
+
+		bool resolve(char** document, size_t rows);
+
+		void locate(char** document, size_t rows, const size_t* corner, size_t* row, size_t* offset);
+
+		void position(char** document, size_t row);
+
+		size_t removeInvalid();
+
+		struct Checkpoint
+		{
+			size_t corner[6]; //Sizes of face vertex, texture and normal, line vertex and texture, and point vertex indices
+			int    count[3];  //Vertices, textures and normals parsed before
+		};
+
+		void grow(); //Only called with WAVEFRONT_OBJ_PROFILE, declared always so the class layout does not depend on the macro
+
+		std::vector<size_t> capacities; //List capacities after the last row
+
 		FILE* file;
 		std::string                                        path;
 		std::string                                        materialFile;
 		std::vector<std::tuple<std::string, size_t>>       materialFace;
-		std::vector<std::tuple<char, std::string, size_t>> information;
+		std::vector<std::tuple<char, std::string, size_t>> informationFace;
+		std::vector<std::tuple<std::string, std::string, size_t>> recordFace;
 		bool                                               triangulate;
+		unsigned int                                       options;
+		std::function<bool(const std::string&)>            select;
+		bool                                               selectObject;
+		bool                                               selectGroup;
+		std::vector<size_t>                                vertexOffset; //Only if extents and not all vertices are xyz
+		std::vector<Checkpoint>                            checkpoints;  //Item counts where they changed between elements
+		std::vector<size_t>                                continuations; //Offsets of the newlines joined into a row by a backslash
 	};
 
 	//-------------------------------------------------------------------------------------------------------
 
 	char* trim(char*);
 
+	bool isspace(const char&);
+
+	bool iseol(const char&);
+
+	unsigned int lineOption(const char*);
+
 	bool parse(const char*, Vertex&);
 
 	bool parse(const char*, Normal&);
 
 	bool parse(const char*, Texture&);
 
-	bool parse(const char*, Point&, size_t);
+	bool parse(const char*, Point&);
 
-	bool parse(const char*, Line&, size_t);
+	bool parse(const char*, Line&, unsigned int = standard);
 
-	bool parse(const char*, Face&, size_t, bool);
+	bool parse(const char*, Face&, bool, unsigned int = standard);
 
 	bool parse(char*, std::string&);
 
@@ -158,17 +411,58 @@ namespace obj
 
 	bool parse(char*, std::vector<std::tuple<char, std::string, size_t>>&, size_t);
 
-	size_t createMemory(FILE*, char*&, size_t&);
+	bool parse(char*, std::vector<std::tuple<std::string, std::string, size_t>>&, size_t);
+
+	bool parse(const char*, Parameter&);
+
+	bool keyword(const char*, const char*);
+
+	bool strtof(const char*, float&, const char*&);
+
+	size_t createMemory(FILE*, char*&, size_t&, std::vector<size_t>&);
+
+	size_t createMemory(const char*, char*&, size_t, std::vector<size_t>&);
+
+	size_t createRows(char*&, size_t, std::vector<size_t>&);
+
+	void join(char*, size_t);
 
 	bool createDocument(char*&, size_t, char**&, size_t);
 
-	void insert_indices(List<int>&, const std::vector<int>&, bool);
+	void diagnose(const char*, const char*, size_t, Error&);
+
+	void insert_indices(List<int>&, const std::vector<int>&, size_t, bool);
 
 	void triangulate_indices(List<int>&, const std::vector<int>&);
 
+	size_t removeUnreferenced(Load&);
+
+	size_t resolve(std::vector<int>&, const std::vector<std::pair<size_t, int>>&, int, bool = false);
+
+	size_t removeInvalid(List<int>* const*, const int*, size_t, std::vector<size_t>&);
+
+	template <typename Function>
+	void parallel(size_t, size_t, Function);
+
+	template <typename T>
+	size_t reserved(const List<T>&);
+
+	template <typename T>
+	size_t used(const List<T>&);
+
+	template <typename T>
+	void shrink(std::vector<T>&, bool);
+
+	template <typename T>
+	void shrink(List<T>&, bool);
+
+	double elapsed(std::chrono::steady_clock::time_point&);
+
+	size_t sample(const std::function<size_t()>&, size_t&);
+
 	//-------------------------------------------------------------------------------------------------------
 
-	inline Load::Load(const bool triangulate) : file(nullptr), triangulate(triangulate) { }
+	inline Load::Load(const bool triangulate, const unsigned int options) : skipped(0), cancel(nullptr), interval(1 << 16), file(nullptr), triangulate(triangulate), options(options), selectObject(false), selectGroup(false) { }
 
 	inline Load::~Load() { close(); }
 
@@ -182,7 +476,9 @@ namespace obj
 
 		if (file) return true;
 
-		printf("Impossible to open obj the file !\n");
+		error.code = fileError;
+
+		error.file = path;
 
 		return false;
 	}
@@ -192,13 +488,27 @@ namespace obj
 		vertex.clear();
 		texture.clear();
 		normal.clear();
+		parameter.clear();
 		face.clear();
 		line.clear();
 		point.clear();
 
-		information.clear();
+		hierarchy.clear();
+		bounds.clear();
+		vertexOffset.clear();
+		checkpoints.clear();
+		continuations.clear();
+
+		informationFace.clear();
+		recordFace.clear();
 		materialFace.clear();
 		materialFile.clear();
+
+		profile.clear();
+
+		error.clear();
+
+		skipped = 0;
 	}
 
 	inline void Load::close()
@@ -216,1244 +526,5114 @@ namespace obj
 
 		clear();
 
+		auto start = std::chrono::steady_clock::now();
+
+		const auto first = start;
+
+		size_t count(counter ? counter() : 0);
+
 		if (!open(path))
 			return false;
 
 		struct stat st {};
-		stat(path.c_str(), &st);
+		::stat(path.c_str(), &st);
 		size_t size = st.st_size;
 
+		profile.bytes = size;
+
+		profile.open = elapsed(start);
+
+		profile.counter[0] = sample(counter, count);
+
 		if (size == 0)
+		{
+			error.code = emptyError;
+
+			error.file = path;
+
 			return false;
+		}
 
 		char* memory = nullptr;
 
-		const auto rows = createMemory(file, memory, size);
+		const auto rows = createMemory(file, memory, size, continuations);
 
-		if (rows == 0)
-			return false;
+		profile.rows = rows;
+
+		profile.read = elapsed(start);
+
+		profile.counter[1] = sample(counter, count);
+
+		if (rows == 0 || memory == nullptr)
+		{
+			error.code = fileError;
+
+			error.file = path;
 
-		if (memory == nullptr)
 			return false;
+		}
 
 		char** document = nullptr;
 
 		const auto create = createDocument(memory, size, document, rows);
 
-		if (!create)
-			return false;
+		profile.document = elapsed(start);
+
+		profile.counter[2] = sample(counter, count);
+
+		if (!create || document == nullptr)
+		{
+			delete[] memory;
 
-		if (document == nullptr)
 			return false;
+		}
 
 		const auto res = load(document, rows);
 
+		profile.parse = elapsed(start);
+
+		profile.counter[3] = sample(counter, count);
+
 		delete[] memory;
 
 		delete[] document;
 
 		close();
 
+		profile.total = elapsed(start = first);
+
+		if (profiler)
+			profiler(profile);
+
 		return res;
 	}
 
-	inline bool Load::load(char** document, const size_t rows)
+	inline bool Load::load(const char* data, const size_t size)
 	{
-		if (document == nullptr) return false;
+		close();
 
-		char* line;
+		clear();
 
-		std::string text;
+		path.clear();
 
-		auto proceed(true);
+		auto start = std::chrono::steady_clock::now();
 
-		for (size_t row = 0; row < rows; row++)
-		{
-			line = trim(document[row]);
-
-			if (*line == 'f' && *(line + 1) == ' ')
-				proceed = parse(line + 2, face, vertex.size(), triangulate);
-			else if (*line == 'v' && *(line + 1) == ' ')
-				proceed = parse(line + 2, vertex);
-			else if (*line == 'v' && *(line + 1) == 'n')
-				proceed = parse(line + 3, normal);
-			else if (*line == 'v' && *(line + 1) == 't')
-				proceed = parse(line + 3, texture);
-			else if (*line == 'u')
-				proceed = parse(line, materialFace, face.vertex.size());
-			else if ((*line == '#' || *line == 'o' || *line == 'g' || *line == 's') && *(line + 1) == ' ')
-				proceed = parse(line, information, face.vertex.size());
-			else if (*line == 'l' && *(line + 1) == ' ')
-				proceed = parse(line + 2, this->line, vertex.size());
-			else if (*line == 'p' && *(line + 1) == ' ')
-				proceed = parse(line + 2, point, vertex.size());
-			else if (*line == 'm')
-				proceed = parse(line, materialFile);
-
-			if (proceed == false) return false;
-		}
+		const auto first = start;
 
-		return true;
-	}
+		size_t count(counter ? counter() : 0);
 
-	inline std::string Load::mtllib()
-	{
-		if (materialFile.empty())
+		profile.bytes = size;
+
+		char* memory = nullptr;
+
+		const auto rows = createMemory(data, memory, size, continuations);
+
+		profile.rows = rows;
+
+		profile.read = elapsed(start);
+
+		profile.counter[1] = sample(counter, count);
+
+		if (rows == 0 || memory == nullptr)
 		{
-			std::string mtl(path);
+			error.code = emptyError;
 
-			const auto find = mtl.rfind('.');
+			return false;
+		}
 
-			if (find == std::string::npos)
-				return {};
+		char** document = nullptr;
 
-			mtl.erase(find + 1);
+		const auto create = createDocument(memory, size, document, rows);
 
-			mtl += "mtl";
+		profile.document = elapsed(start);
 
-			return mtl;
+		profile.counter[2] = sample(counter, count);
+
+		if (!create || document == nullptr)
+		{
+			delete[] memory;
+
+			return false;
 		}
 
-		std::string directory(path);
+		const auto res = load(document, rows);
 
-		auto find = directory.rfind('\\');
+		profile.parse = elapsed(start);
 
-		if (find == std::string::npos)
-			find = directory.rfind('/');
+		profile.counter[3] = sample(counter, count);
 
-		if (find == std::string::npos)
-			return {};
+		delete[] memory;
 
-		directory.erase(find + 1);
+		delete[] document;
 
-		return directory + materialFile;
+		profile.total = elapsed(start = first);
+
+		if (profiler)
+			profiler(profile);
+
+		return res;
 	}
 
-	inline std::vector<std::tuple<std::string, size_t>>& Load::usemtl()
+	inline bool Load::load(const std::string& path, const std::function<bool(const std::string&)>& select, const bool compact)
 	{
-		return materialFace;
-	}
+		this->select = select;
 
-	//-------------------------------------------------------------------------------------------------------
+		const auto res = load(path);
 
-	template <typename T>
-	size_t List<T>::size() const { return s.size(); }
+		this->select = nullptr;
 
-	template <typename T>
-	bool List<T>::empty() const { return s.empty(); }
+		if (res && compact)
+			removeUnreferenced(*this);
 
-	template <typename T>
-	void List<T>::insert(const std::vector<T>& list)
-	{
-		v.insert(v.end(), list.begin(), list.end());
-		s.emplace_back(static_cast<int>(list.size()));
+		return res;
 	}
 
-	template <typename T>
-	void List<T>::insert(typename std::vector<T>::iterator begin, typename std::vector<T>::iterator end)
+	inline bool Load::load(const std::string& path, const std::set<std::string>& names, const bool compact)
 	{
-		v.insert(v.end(), begin, end);
-		s.emplace_back(static_cast<int>(end - begin));
+		return load(path, [&names](const std::string& name) { return names.find(name) != names.end(); }, compact);
 	}
 
-	template <typename T>
-	void List<T>::clear()
+	// Shared by the file and memory loads, profile.memory is set however parsing ends
+	inline bool Load::load(char** document, const size_t rows)
 	{
-		v.clear();
-		s.clear();
-	}
+		if (document == nullptr) return false;
 
-	//-------------------------------------------------------------------------------------------------------
+		const auto res = parseRows(document, rows);
 
-	inline void Face::clear()
-	{
-		vertex.clear();
-		texture.clear();
-		normal.clear();
-	}
+		profile.memory = profile.bytes + rows * sizeof(char*) + reserved(vertex) + reserved(texture) + reserved(normal);
+		profile.memory += reserved(face.vertex) + reserved(face.texture) + reserved(face.normal);
+		profile.memory += reserved(line.vertex) + reserved(line.texture) + reserved(point.vertex);
 
-	inline void Line::clear()
-	{
-		vertex.clear();
-		texture.clear();
+		return res;
 	}
 
-	inline void Point::clear()
+	inline bool Load::parseRows(char** document, const size_t rows)
 	{
-		vertex.clear();
-	}
+		char* line;
 
-	//-------------------------------------------------------------------------------------------------------
+		std::string text;
 
-	inline size_t createMemory(FILE* file, char*& memory, size_t& size)
-	{
-		if (file == nullptr || size == 0)
-			return 0;
+		auto proceed(true);
 
-		memory = new char[size + 1];
+		auto selected(!select); //Without a filter everything is selected
 
-		if (memory == nullptr)
-			return 0;
+		auto changed(false); //Items were added since the last checkpoint
 
-		size = fread(memory, sizeof(char), size, file);
+		checkpoints.clear();
 
-		size_t rows(0);
+		selectObject = selectGroup = false;
 
-		for (size_t i = 0; i < size; i++)
-		{
-			if (memory[i] == '\n')
-			{
-				rows++;
+		const auto mask = select ? options | metadata : options; //A filter needs the o and g lines
 
-				memory[i] = '\0';
-			}
-		}
+#ifdef WAVEFRONT_OBJ_PROFILE
+		capacities.clear();
 
-		rows++;
+		grow();
+#endif
 
-		memory[size] = '\0'; //EOF
+		const auto start = std::chrono::steady_clock::now();
 
-		if (rows == 0)
+		const auto step = std::max(interval, static_cast<size_t>(1));
+
+		auto next = progress || cancel ? 0 : rows; //First check before row 0, never reached without progress or cancel
+
+		for (size_t row = 0; row < rows; row++)
 		{
-			delete[] memory;
+			if (row == next)
+			{
+				next = std::min(next + step, rows);
 
-			memory = nullptr;
-		}
+				if (!report(static_cast<size_t>(document[row] - document[0]), row, start))
+				{
+					error.code = cancelError;
+					error.row = row + 1;
+					error.column = 1;
+					error.file = path;
 
-		return memory ? rows : 0;
-	}
+					position(document, row);
 
-	inline bool createDocument(char*& memory, const size_t size, char**& document, const size_t rows)
-	{
-		if (size == 0 || rows == 0)
-			return false;
+					return false;
+				}
+			}
 
-		document = new char* [rows];
+			line = document[row];
 
-		if (document == nullptr)
-			return false;
+			while (isspace(*line)) line++;
 
-		document[0] = &memory[0];
+#ifdef WAVEFRONT_OBJ_PROFILE
+			profile.count(line);
+#endif
 
-		size_t row(1);
+			if ((lineOption(line) & mask) == 0) //Unwanted line types are skipped
+				continue;
 
-		for (size_t i = 1; i < size; i++)
-		{
-			if (memory[i] == '\0')
+			switch (*line) //Trailing whitespace is left for the parsers, only names are trimmed
 			{
-				document[row] = &memory[i + 1]; //memory[size] = EOF (see above)
+			case 'f':
+				if (isspace(*(line + 1)))
+				{
+					const auto corner = face.vertex.v.size();
 
-				row++;
-			}
-		}
+					if (selected)
+					{
+						checkpoint(changed);
 
-		if (row != rows)
-		{
-			delete[] document;
+						proceed = parse(line + 2, face, triangulate, options);
+					}
 
-			document = nullptr;
-		}
+					if (proceed && (options & extents))
+						extent(corner);
+				}
+				break;
+			case 'v':
+				switch (*(line + 1))
+				{
+				case ' ':
+				case '\t':
+					if ((proceed = parse(line + 2, vertex)))
+						changed = true; //A failed row must not reset a pending change
+
+					if (proceed && (options & extents))
+						extent();
+					break;
+				case 't':
+					if (isspace(*(line + 2)) && (proceed = parse(line + 3, texture)))
+						changed = true;
+					break;
+				case 'n':
+					if (isspace(*(line + 2)) && (proceed = parse(line + 3, normal)))
+						changed = true;
+					break;
+				case 'p':
+					if (isspace(*(line + 2)) && (options & freeform))
+						proceed = parse(line + 3, parameter);
+					break;
+				}
+				break;
+			case 'u':
+				if (keyword(line, "usemtl"))
+					proceed = parse(line, materialFace, face.vertex.size());
+				else if (options & freeform) //usemap
+					proceed = parse(line, recordFace, face.vertex.size());
+				break;
+			case 'm':
+				if (keyword(line, "mtllib"))
+					proceed = parse(line, materialFile);
+				else if (options & freeform) //mg, maplib
+					proceed = parse(line, recordFace, face.vertex.size());
+				break;
+			case '#':
+			case 'o':
+			case 'g':
+			case 's':
+				if (!isspace(*(line + 1)) && !iseol(*(line + 1)))
+				{
+					if ((options & freeform) && *line != '#') //surf, sp, step, stech, shadow_obj
+						proceed = parse(line, recordFace, face.vertex.size());
+				}
+				else //A bare keyword has an empty name
+				{
+					proceed = parse(line, informationFace, face.vertex.size());
 
-		return document ? true : false;
-	}
+					if (*line != '#')
+						hierarchy.open(*line, std::get<1>(informationFace.back()), face.vertex.size());
 
-	//-------------------------------------------------------------------------------------------------------
+					if (select && (*line == 'o' || *line == 'g'))
+						selected = filter(*line, std::get<1>(informationFace.back()));
+				}
+				break;
+			case 'l':
+				if (isspace(*(line + 1)) && selected)
+				{
+					checkpoint(changed);
 
-	inline bool strtoi(const char* text, int& i, const char*& end)
-	{
-		static int v;
+					proceed = parse(line + 2, this->line, options);
+				}
+				else if (!isspace(*(line + 1)) && (options & freeform)) //lod
+					proceed = parse(line, recordFace, face.vertex.size());
+				break;
+			case 'p':
+				if (isspace(*(line + 1)) && selected)
+				{
+					checkpoint(changed);
+
+					proceed = parse(line + 2, point);
+				}
+				else if (!isspace(*(line + 1)) && (options & freeform)) //parm
+					proceed = parse(line, recordFace, face.vertex.size());
+				break;
+			default: //cstype, deg, bmat, curv, curv2, trim, hole, scrv, end, con, bevel, c_interp, d_interp, ctech, trace_obj
+				proceed = parse(line, recordFace, face.vertex.size());
+				break;
+			}
 
-		static const char* p;
+#ifdef WAVEFRONT_OBJ_PROFILE
+			grow();
+#endif
 
-		static bool negative;
+			if (proceed == false)
+			{
+				if (error.code == noError) //Only the first failure is diagnosed
+				{
+					diagnose(document[row], line, row, error);
 
-		p = text;
+					error.file = path;
 
-		negative = false;
+					position(document, row);
+				}
 
-		while (*p == ' ') p++;
+				if ((options & lenient) == 0)
+					return false;
 
-		if (*p == '-')
-		{
-			negative = true;
+				skipped++;
 
-			p++;
+				proceed = true;
+			}
 		}
-		else if (*p == '+')
-			p++;
 
-		v = 0;
+		hierarchy.close(face.vertex.size());
 
-		while (*p >= '0' && *p <= '9')
-		{
-			v = (v * 10) + (*p - '0');
+		if (!resolve(document, rows))
+			return false;
 
-			p++;
-		}
+		if (progress)
+			report(profile.bytes, rows, start);
 
-		end = p;
+		return true;
+	}
 
-		i = negative ? -v : v;
+	inline void Load::checkpoint(bool& changed)
+	{
+		if (!changed) return;
+
+		changed = false;
 
-		return text == end ? false : true;
+		Checkpoint item;
+
+		item.corner[0] = face.vertex.v.size();
+		item.corner[1] = face.texture.v.size();
+		item.corner[2] = face.normal.v.size();
+		item.corner[3] = line.vertex.v.size();
+		item.corner[4] = line.texture.v.size();
+		item.corner[5] = point.vertex.v.size();
+
+		item.count[0] = static_cast<int>(vertex.size());
+		item.count[1] = static_cast<int>(texture.size());
+		item.count[2] = static_cast<int>(normal.size());
+
+		checkpoints.push_back(item);
 	}
 
-	inline bool strtof(const char* text, float& d, const char*& end)
+	inline bool Load::resolve(char** document, const size_t rows)
 	{
-		static float v;
+		std::vector<int>* index[] = { &face.vertex.v, &face.texture.v, &face.normal.v, &line.vertex.v, &line.texture.v, &point.vertex.v };
 
-		static const char* p;
+		const size_t attribute[] = { 0, 1, 2, 0, 1, 0 }; //Vertex, texture or normal
 
-		static int exponent;
+		const int total[] = { static_cast<int>(vertex.size()), static_cast<int>(texture.size()), static_cast<int>(normal.size()) };
 
-		static float factor;
+		const unsigned int loaded[] = { positions, textures, normals };
 
-		static bool negExp;
+		std::vector<std::pair<size_t, int>> segment(checkpoints.size());
 
-		static bool negative;
+		size_t invalid[6];
 
-		p = text;
+		auto valid(true);
 
-		negative = false;
+		for (size_t list = 0; list < 6; list++)
+		{
+			invalid[list] = index[list]->size();
 
-		while (*p == ' ') ++p;
+			if ((options & loaded[attribute[list]]) == 0) //Nothing to resolve against, the indices are kept
+				continue;
 
-		if (*p == '-')
-		{
-			negative = true;
+			for (size_t item = 0; item < checkpoints.size(); item++)
+				segment[item] = std::make_pair(checkpoints[item].corner[list], checkpoints[item].count[attribute[list]]);
 
-			p++;
+			invalid[list] = obj::resolve(*index[list], segment, total[attribute[list]], (options & threaded) != 0);
+
+			if (invalid[list] != index[list]->size())
+				valid = false;
 		}
-		else if (*p == '+')
-			p++;
 
-		v = 0.0;
+		if (valid)
+			return true;
 
-		while (*p >= '0' && *p <= '9')
+		if (error.code == noError) //The rows are only searched for the first failure
 		{
-			v = v * 10.0f + (float)(*p - '0');
+			size_t row[6], offset[6];
 
-			p++;
-		}
+			locate(document, rows, invalid, row, offset);
 
-		if (*p == '.')
-		{
-			p++;
+			size_t list = 0;
 
-			factor = 0.1f;
+			for (size_t item = 1; item < 6; item++)
+				if (row[item] < row[list]) list = item;
 
-			while (*p >= '0' && *p <= '9')
+			const auto item = (*index[list])[invalid[list]];
+
+			error.code = indexError;
+			error.row = row[list] + 1;
+			error.column = 1;
+			error.token = std::to_string(static_cast<long long>(item < 0 ? item : item + 1)); //As written in the file
+			error.file = path;
+
+			if (row[list] < rows) //Column of the v/vt/vn group holding the corner
 			{
-				v += factor * (float)(*p - '0');
+				const char* text = document[row[list]];
 
-				factor *= 0.1f;
+				while (isspace(*text)) text++;
 
-				p++;
-			}
-		}
+				const auto keyword = *text;
 
-		if (*p == 'e' || *p == 'E')
-		{
-			++p;
+				text++;
 
-			exponent = 0;
+				size_t group(offset[list]), groups(0);
 
-			negExp = false;
+				for (const char* p = text; *p; groups++)
+				{
+					while (isspace(*p)) p++;
 
-			if (*p == '-')
-			{
-				negExp = true;
+					if (*p == '\0') break;
 
-				p++;
-			}
-			else if (*p == '+')
-			{
-				p++;
-			}
+					while (*p && !isspace(*p)) p++;
+				}
 
-			while (*p >= '0' && *p <= '9')
-			{
-				exponent = exponent * 10 + (*p - '0');
+				if (keyword == 'f' && triangulate && groups > 3) //Fan triangles (1, 2, 0), (2, 3, 0) ...
+					group = offset[list] % 3 == 2 ? 0 : offset[list] / 3 + 1 + offset[list] % 3;
 
-				p++;
-			}
+				while (true)
+				{
+					while (isspace(*text)) text++;
+
+					if (*text == '\0' || group-- == 0) break;
 
-			v *= (float)pow(10.0, negExp ? -exponent : exponent);
+					while (*text && !isspace(*text)) text++;
+				}
+
+				error.column = static_cast<size_t>(text - document[row[list]]) + 1;
+
+				position(document, row[list]);
+			}
 		}
 
-		end = p;
+		if ((options & lenient) == 0)
+			return false;
 
-		d = negative ? -v : v;
+		skipped += removeInvalid();
 
-		return text == end ? false : true;
+		return true;
 	}
 
-	//-------------------------------------------------------------------------------------------------------
-
-	inline bool isspace(const char& c)
+	// error.row and error.column count joined rows, they are moved to the line and column in the file
+	inline void Load::position(char** document, const size_t row)
 	{
-		return c == ' ' || c == '\t' || c == '\v';
+		if (continuations.empty() || error.column == 0) return;
+
+		const auto begin = static_cast<size_t>(document[row] - document[0]);
+
+		const auto at = begin + error.column - 1;
+
+		const auto before = std::lower_bound(continuations.begin(), continuations.end(), at); //Joined newlines before the error
+
+		error.row += static_cast<size_t>(before - continuations.begin());
+
+		if (before != continuations.begin() && *(before - 1) >= begin) //The error is on a continued line
+			error.column = at - *(before - 1);
 	}
 
-	inline char* trim(char* p)
+	inline void Load::locate(char** document, const size_t rows, const size_t* corner, size_t* row, size_t* offset)
 	{
-		static char* e;
+		Face  rowFace; //Elements of one row
+		Line  rowLine;
+		Point rowPoint;
 
-		if (p == nullptr) return nullptr;
+		size_t size[6] = { 0, 0, 0, 0, 0, 0 }; //Corners of each list before the row
 
-		while (std::isspace(*p) && *p != '\0') p++;
+		auto selected(!select);
 
-		e = p;
+		const auto mask = select ? options | metadata : options;
 
-		while (*e != '\0') e++;
+		for (size_t list = 0; list < 6; list++)
+			row[list] = offset[list] = rows;
 
-		if (e != p) e--;
+		for (size_t number = 0; number < rows; number++) //The element rows are parsed again as in load
+		{
+			char* text = document[number];
 
-		while (std::isspace(*e) && e != p) e--;
+			while (isspace(*text)) text++;
 
-		if (e != p) e++;
+			if ((lineOption(text) & mask) == 0 || !(isspace(*(text + 1)) || iseol(*(text + 1))))
+				continue;
 
-		*e = '\0';
+			if (select && (*text == 'o' || *text == 'g'))
+			{
+				selected = filter(*text, trim(text + 1));
 
-		return p;
-	}
+				continue;
+			}
 
-	//-------------------------------------------------------------------------------------------------------
+			if (!selected || !isspace(*(text + 1))) //As in load, a bare f, l or p is not an element
+				continue;
 
-	inline bool parse(char* line, std::string& file)
-	{
-		line++; // 'm'
+			rowFace.clear();
+			rowLine.clear();
+			rowPoint.clear();
 
-		if (*line++ != 't') return false;
-		if (*line++ != 'l') return false;
-		if (*line++ != 'l') return false;
-		if (*line++ != 'i') return false;
-		if (*line++ != 'b') return false;
+			if (*text == 'f')
+				parse(text + 2, rowFace, triangulate, options);
+			else if (*text == 'l')
+				parse(text + 2, rowLine, options);
+			else if (*text == 'p')
+				parse(text + 2, rowPoint);
+			else
+				continue;
 
-		file = trim(line);
+			const size_t added[] = { rowFace.vertex.v.size(), rowFace.texture.v.size(), rowFace.normal.v.size(), rowLine.vertex.v.size(), rowLine.texture.v.size(), rowPoint.vertex.v.size() };
 
-		return true;
+			for (size_t list = 0; list < 6; list++)
+			{
+				if (row[list] == rows && corner[list] < size[list] + added[list])
+				{
+					row[list] = number;
+
+					offset[list] = corner[list] - size[list];
+				}
+
+				size[list] += added[list];
+			}
+		}
 	}
 
-	inline bool parse(char* line, std::vector<std::tuple<std::string, size_t>>& list, const size_t face)
+	inline size_t Load::removeInvalid()
 	{
-		line++; // 'u'
+		const int total[] = { options & positions ? static_cast<int>(vertex.size()) : -1, options & textures ? static_cast<int>(texture.size()) : -1, options & normals ? static_cast<int>(normal.size()) : -1 };
 
-		if (*line++ != 's') return false;
-		if (*line++ != 'e') return false;
-		if (*line++ != 'm') return false;
-		if (*line++ != 't') return false;
-		if (*line++ != 'l') return false;
+		std::vector<size_t> kept;
 
-		list.emplace_back(trim(line), face);
+		List<int>* lines[] = { &line.vertex, &line.texture };
 
-		return true;
-	}
+		List<int>* points[] = { &point.vertex };
 
-	inline bool parse(char* line, std::vector<std::tuple<char, std::string, size_t>>& information, const size_t face)
-	{
-		information.emplace_back(*line, trim(line + 1), face);
+		const auto removed = obj::removeInvalid(lines, total, 2, kept) + obj::removeInvalid(points, total, 1, kept); //Vertex and texture totals
 
-		return true;
-	}
+		List<int>* faces[] = { &face.vertex, &face.texture, &face.normal };
 
-	inline bool parse(const char* line, Vertex& item)
-	{
-		static std::vector<float> vertex(6);
+		const auto faceRemoved = obj::removeInvalid(faces, total, 3, kept);
 
-		if (!strtof(line, vertex[0], line))
-			return false;
+		if (faceRemoved == 0)
+			return removed;
 
-		if (!strtof(line, vertex[1], line))
-			return false;
+		for (auto& item : materialFace)
+			std::get<1>(item) = kept[std::get<1>(item)];
 
-		if (!strtof(line, vertex[2], line))
-			return false;
+		for (auto& item : informationFace)
+			std::get<2>(item) = kept[std::get<2>(item)];
 
-		if (!strtof(line, vertex[3], line))
-		{
-			item.insert(vertex.begin(), vertex.begin() + 3); //x, y, z
+		for (auto& item : recordFace)
+			std::get<2>(item) = kept[std::get<2>(item)];
 
-			return true;
-		}
+		hierarchy.renumber(kept);
 
-		if (!strtof(line, vertex[4], line))
-		{
-			item.insert(vertex.begin(), vertex.begin() + 4); //x, y, z, w
+		return removed + faceRemoved;
+	}
 
+	inline bool Load::report(const size_t bytes, const size_t rows, const std::chrono::steady_clock::time_point& start)
+	{
+		if (cancel && cancel->load(std::memory_order_relaxed))
+			return false;
+
+		if (!progress)
 			return true;
-		}
 
-		if (!strtof(line, vertex[5], line))
-			return false;
+		Progress state;
 
-		item.insert(vertex); //x, y, z, r, g, b
+		state.bytes = std::min(bytes, profile.bytes);
+		state.total = profile.bytes;
+		state.rows = rows;
+		state.elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		state.remaining = state.bytes ? state.elapsed * static_cast<double>(state.total - state.bytes) / static_cast<double>(state.bytes) : 0.0;
+
+		progress(state);
 
 		return true;
 	}
 
-	inline bool parse(const char* line, Normal& item)
+	inline bool Load::filter(const char type, const std::string& name)
 	{
-		static std::vector<float> normal(3);
+		if (type == 'o')
+			selectObject = select(name);
+		else
+		{
+			selectGroup = false;
 
-		if (!strtof(line, normal[0], line))
-			return false;
+			size_t first(0);
 
-		if (!strtof(line, normal[1], line))
-			return false;
+			while (first < name.size() && !selectGroup) //"g name1 name2 ..."
+			{
+				const auto last = std::min(name.find_first_of(" \t", first), name.size());
 
-		if (!strtof(line, normal[2], line))
-			return false;
+				if (last > first)
+					selectGroup = select(name.substr(first, last - first));
 
-		item.insert(normal);
+				first = last + 1;
+			}
+		}
 
-		return true;
+		return selectObject || selectGroup;
 	}
 
-	inline bool parse(const char* line, Texture& item)
+	inline void Load::grow()
 	{
-		static std::vector<float> texture(3);
+		const size_t current[] =
+		{
+			vertex.v.capacity(), vertex.s.capacity(), texture.v.capacity(), texture.s.capacity(), normal.v.capacity(), normal.s.capacity(),
+			face.vertex.v.capacity(), face.vertex.s.capacity(), face.texture.v.capacity(), face.texture.s.capacity(), face.normal.v.capacity(), face.normal.s.capacity(),
+			line.vertex.v.capacity(), line.vertex.s.capacity(), line.texture.v.capacity(), line.texture.s.capacity(), point.vertex.v.capacity(), point.vertex.s.capacity(),
+			parameter.v.capacity(), parameter.s.capacity()
+		};
 
-		if (!strtof(line, texture[0], line))
-			return false;
+		const auto count = sizeof(current) / sizeof(current[0]);
 
-		if (!strtof(line, texture[1], line))
+		if (capacities.size() != count)
+			capacities.assign(current, current + count);
+
+		for (size_t index = 0; index < count; index++)
 		{
-			item.insert(texture.begin(), texture.begin() + 1);
+			if (current[index] == capacities[index]) continue;
 
-			return true;
+			capacities[index] = current[index];
+
+			profile.reallocations++;
 		}
+	}
 
-		if (!strtof(line, texture[2], line))
-		{
+	inline void Load::extent()
+	{
+		const auto size = static_cast<size_t>(vertex.s.back());
+
+		const auto offset = vertex.v.size() - size;
+
+		if (size != 3 && vertexOffset.empty()) //From now on vertices are found through offsets
+		{
+			for (size_t index = 0; index + 1 < vertex.size(); index++)
+				vertexOffset.emplace_back(index * 3);
+		}
+
+		if (!vertexOffset.empty())
+			vertexOffset.emplace_back(offset);
+
+		bounds.insert(&vertex.v[offset]);
+	}
+
+	inline void Load::extent(const size_t corner)
+	{
+		for (size_t index = corner; index < face.vertex.v.size(); index++)
+		{
+			auto item = face.vertex.v[index];
+
+			if (item < 0) //Not resolved yet, relative to the vertices parsed so far
+				item += static_cast<int>(vertex.size());
+
+			if (item < 0 || static_cast<size_t>(item) >= vertex.size())
+				continue;
+
+			hierarchy.insert(&vertex.v[vertexOffset.empty() ? item * 3 : vertexOffset[item]]);
+		}
+	}
+
+	inline std::string Load::mtllib()
+	{
+		if (materialFile.empty())
+		{
+			std::string mtl(path);
+
+			const auto find = mtl.rfind('.');
+
+			if (find == std::string::npos)
+				return {};
+
+			mtl.erase(find + 1);
+
+			mtl += "mtl";
+
+			return mtl;
+		}
+
+		std::string directory(path);
+
+		auto find = directory.rfind('\\');
+
+		if (find == std::string::npos)
+			find = directory.rfind('/');
+
+		if (find == std::string::npos)
+			return {};
+
+		directory.erase(find + 1);
+
+		return directory + materialFile;
+	}
+
+	inline std::vector<std::tuple<std::string, size_t>>& Load::usemtl()
+	{
+		return materialFace;
+	}
+
+	inline std::vector<std::tuple<char, std::string, size_t>>& Load::information()
+	{
+		return informationFace;
+	}
+
+	inline std::vector<std::tuple<std::string, std::string, size_t>>& Load::records()
+	{
+		return recordFace;
+	}
+
+	inline std::vector<MemoryUsage> Load::memoryUsage() const
+	{
+		std::vector<MemoryUsage> usage;
+
+		auto list = [&usage](const char* name, const List<int>* index, const List<float>* item)
+		{
+			usage.push_back({ name, index ? used(*index) : used(*item), index ? reserved(*index) : reserved(*item) });
+		};
+
+		list("vertex", nullptr, &vertex);
+		list("texture", nullptr, &texture);
+		list("normal", nullptr, &normal);
+		list("parameter", nullptr, &parameter);
+		list("face.vertex", &face.vertex, nullptr);
+		list("face.texture", &face.texture, nullptr);
+		list("face.normal", &face.normal, nullptr);
+		list("line.vertex", &line.vertex, nullptr);
+		list("line.texture", &line.texture, nullptr);
+		list("point.vertex", &point.vertex, nullptr);
+
+		MemoryUsage record{ "records", 0, 0 }; //usemtl, #, o, g, s and free-form records with their text
+
+		record.size = materialFace.size() * sizeof(materialFace[0]) + informationFace.size() * sizeof(informationFace[0]) + recordFace.size() * sizeof(recordFace[0]);
+		record.capacity = materialFace.capacity() * sizeof(materialFace[0]) + informationFace.capacity() * sizeof(informationFace[0]) + recordFace.capacity() * sizeof(recordFace[0]);
+
+		for (const auto& item : materialFace)
+			record.size += std::get<0>(item).size(), record.capacity += std::get<0>(item).capacity();
+
+		for (const auto& item : informationFace)
+			record.size += std::get<1>(item).size(), record.capacity += std::get<1>(item).capacity();
+
+		for (const auto& item : recordFace)
+		{
+			record.size += std::get<0>(item).size() + std::get<1>(item).size();
+			record.capacity += std::get<0>(item).capacity() + std::get<1>(item).capacity();
+		}
+
+		usage.push_back(record);
+
+		usage.push_back({ "loading", 0, (vertexOffset.capacity() + continuations.capacity()) * sizeof(size_t) + checkpoints.capacity() * sizeof(Checkpoint) }); //Only needed while loading
+
+		return usage;
+	}
+
+	inline void Load::compact(const bool exact)
+	{
+		shrink(vertex, exact);
+		shrink(texture, exact);
+		shrink(normal, exact);
+		shrink(parameter, exact);
+		shrink(face.vertex, exact);
+		shrink(face.texture, exact);
+		shrink(face.normal, exact);
+		shrink(line.vertex, exact);
+		shrink(line.texture, exact);
+		shrink(point.vertex, exact);
+
+		shrink(materialFace, exact);
+		shrink(informationFace, exact);
+		shrink(recordFace, exact);
+
+		std::vector<size_t>().swap(vertexOffset);
+		std::vector<Checkpoint>().swap(checkpoints);
+		std::vector<size_t>().swap(continuations);
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+
+	template <typename T>
+	size_t List<T>::size() const { return s.size(); }
+
+	template <typename T>
+	bool List<T>::empty() const { return s.empty(); }
+
+	template <typename T>
+	void List<T>::insert(const std::vector<T>& list)
+	{
+		v.insert(v.end(), list.begin(), list.end());
+		s.emplace_back(static_cast<int>(list.size()));
+	}
+
+	template <typename T>
+	void List<T>::insert(typename std::vector<T>::iterator begin, typename std::vector<T>::iterator end)
+	{
+		v.insert(v.end(), begin, end);
+		s.emplace_back(static_cast<int>(end - begin));
+	}
+
+	template <typename T>
+	void List<T>::clear()
+	{
+		v.clear();
+		s.clear();
+	}
+
+	template <typename T>
+	size_t reserved(const List<T>& list) //Bytes reserved by the list
+	{
+		return list.v.capacity() * sizeof(T) + list.s.capacity() * sizeof(int);
+	}
+
+	template <typename T>
+	size_t used(const List<T>& list) //Bytes used by the list
+	{
+		return list.v.size() * sizeof(T) + list.s.size() * sizeof(int);
+	}
+
+	template <typename T>
+	void shrink(std::vector<T>& list, const bool exact)
+	{
+		if (exact)
+			std::vector<T>(list.begin(), list.end()).swap(list); //Capacity is the size, shrink_to_fit is only a request
+		else
+			list.shrink_to_fit();
+	}
+
+	template <typename T>
+	void shrink(List<T>& list, const bool exact)
+	{
+		shrink(list.v, exact);
+		shrink(list.s, exact);
+	}
+
+	template <typename T>
+	void offsets(const List<T>& list, std::vector<size_t>& offset)
+	{
+		offset.resize(list.s.size() + 1);
+
+		offset[0] = 0;
+
+		for (size_t index = 0; index < list.s.size(); index++)
+			offset[index + 1] = offset[index] + static_cast<size_t>(list.s[index]);
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+
+	inline void Face::clear()
+	{
+		vertex.clear();
+		texture.clear();
+		normal.clear();
+	}
+
+	inline void Line::clear()
+	{
+		vertex.clear();
+		texture.clear();
+	}
+
+	inline void Point::clear()
+	{
+		vertex.clear();
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+
+	inline void append(std::vector<Range>& list, const Range& range)
+	{
+		if (!list.empty() && list.back().end == range.begin)
+			list.back().end = range.end;
+		else
+			list.emplace_back(range);
+	}
+
+	inline Profile::Profile() { clear(); }
+
+	inline void Profile::clear()
+	{
+		open = read = document = parse = total = 0.0;
+
+		bytes = rows = memory = 0;
+
+		counter[0] = counter[1] = counter[2] = counter[3] = 0;
+
+		vertex = texture = normal = face = line = point = 0;
+
+		material = information = other = reallocations = 0;
+	}
+
+	inline void Profile::count(const char* line)
+	{
+		switch (*line)
+		{
+		case 'f': face++; break;
+		case 'v': *(line + 1) == 't' ? texture++ : *(line + 1) == 'n' ? normal++ : vertex++; break;
+		case 'l': this->line++; break;
+		case 'p': point++; break;
+		case 'u':
+		case 'm': material++; break;
+		case '#':
+		case 'o':
+		case 'g':
+		case 's': information++; break;
+		default: other++;
+		}
+	}
+
+	inline double elapsed(std::chrono::steady_clock::time_point& start) //Milliseconds since start, and restart
+	{
+		const auto now = std::chrono::steady_clock::now();
+
+		const auto time = std::chrono::duration<double, std::milli>(now - start).count();
+
+		start = now;
+
+		return time;
+	}
+
+	inline Error::Error() { clear(); }
+
+	inline void Error::clear()
+	{
+		code = noError;
+
+		row = column = 0;
+
+		token.clear();
+		file.clear();
+	}
+
+	inline std::string Error::message() const
+	{
+		static const char* text[] = { "no error", "impossible to open the file", "empty file", "invalid number", "invalid index", "invalid line", "cancelled" };
+
+		std::string message(file.empty() ? "obj" : file);
+
+		if (row)
+			message += ":" + std::to_string(row) + ":" + std::to_string(column);
+
+		message += ": ";
+		message += text[code];
+
+		if (!token.empty())
+			message += " '" + token + "'";
+
+		return message;
+	}
+
+	inline size_t sample(const std::function<size_t()>& counter, size_t& last) //Change since last, and restart
+	{
+		if (!counter) return 0;
+
+		const auto now = counter();
+
+		const auto change = now - last;
+
+		last = now;
+
+		return change;
+	}
+
+	inline Bounds::Bounds() { clear(); }
+
+	inline void Bounds::clear()
+	{
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			minimum[axis] = HUGE_VALF;
+			maximum[axis] = -HUGE_VALF;
+
+			sum[axis] = 0.0;
+		}
+
+		count = 0;
+	}
+
+	inline bool Bounds::empty() const { return count == 0; }
+
+	inline void Bounds::insert(const float* xyz)
+	{
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			minimum[axis] = std::min(minimum[axis], xyz[axis]);
+			maximum[axis] = std::max(maximum[axis], xyz[axis]);
+
+			sum[axis] += xyz[axis];
+		}
+
+		count++;
+	}
+
+	inline void Bounds::centroid(float* xyz) const
+	{
+		for (size_t axis = 0; axis < 3; axis++)
+			xyz[axis] = count ? static_cast<float>(sum[axis] / static_cast<double>(count)) : 0.0f;
+	}
+
+	inline void Hierarchy::clear()
+	{
+		object.clear();
+		group.clear();
+		smoothing.clear();
+
+		objectName.clear();
+		groupName.clear();
+		activeGroup.clear();
+
+		activeObject = 0;
+		activeSmoothing = 0;
+		begin = 0;
+	}
+
+	inline Object& Hierarchy::current()
+	{
+		if (object.empty()) //Faces before the first 'o' belong to an unnamed object
+		{
+			objectName.emplace(std::string(), 0);
+
+			object.push_back(Object{ std::string(), {}, {}, Bounds() });
+		}
+
+		return object[activeObject];
+	}
+
+	inline void Hierarchy::insert(const float* xyz)
+	{
+		current().bounds.insert(xyz);
+
+		for (const auto& index : activeGroup)
+			group[index].bounds.insert(xyz);
+	}
+
+	inline void Hierarchy::renumber(const std::vector<size_t>& kept)
+	{
+		auto ranges = [&kept](std::vector<Range>& list)
+		{
+			std::vector<Range> item;
+
+			for (const auto& range : list)
+			{
+				if (kept[range.begin] < kept[range.end]) //Ranges left empty are removed
+					append(item, Range{ kept[range.begin], kept[range.end] });
+			}
+
+			list.swap(item);
+		};
+
+		for (auto& item : object)
+			ranges(item.face);
+
+		for (auto& item : group)
+			ranges(item.face);
+
+		std::vector<Smoothing> list;
+
+		for (const auto& item : smoothing)
+		{
+			const Range range{ kept[item.face.begin], kept[item.face.end] };
+
+			if (range.begin == range.end) continue;
+
+			if (!list.empty() && list.back().id == item.id && list.back().face.end == range.begin)
+				list.back().face.end = range.end;
+			else
+				list.push_back(Smoothing{ item.id, range });
+		}
+
+		smoothing.swap(list);
+
+		begin = kept[begin];
+	}
+
+	inline void Hierarchy::close(const size_t face)
+	{
+		if (face <= begin) return;
+
+		const Range range{ begin, face };
+
+		begin = face;
+
+		auto& item = current();
+
+		append(item.face, range);
+
+		for (const auto& index : activeGroup)
+		{
+			append(group[index].face, range);
+
+			if (std::find(item.group.begin(), item.group.end(), index) == item.group.end())
+				item.group.emplace_back(index);
+		}
+
+		if (!smoothing.empty() && smoothing.back().id == activeSmoothing && smoothing.back().face.end == range.begin)
+			smoothing.back().face.end = range.end;
+		else
+			smoothing.push_back(Smoothing{ activeSmoothing, range });
+	}
+
+	inline void Hierarchy::open(const char type, const std::string& name, const size_t face)
+	{
+		close(face);
+
+		if (type == 'o')
+		{
+			const auto find = objectName.emplace(name, object.size());
+
+			if (find.second)
+				object.push_back(Object{ name, {}, {}, Bounds() });
+
+			activeObject = find.first->second;
+		}
+		else if (type == 'g')
+		{
+			activeGroup.clear();
+
+			size_t first(0);
+
+			while (first < name.size()) //"g name1 name2 ..."
+			{
+				const auto last = std::min(name.find_first_of(" \t", first), name.size());
+
+				if (last > first)
+				{
+					const auto find = groupName.emplace(name.substr(first, last - first), group.size());
+
+					if (find.second)
+						group.push_back(Group{ name.substr(first, last - first), {}, Bounds() });
+
+					activeGroup.emplace_back(find.first->second);
+				}
+
+				first = last + 1;
+			}
+		}
+		else if (type == 's')
+			activeSmoothing = name == "off" ? 0 : atoi(name.c_str());
+	}
+
+	inline const Object* Hierarchy::findObject(const std::string& name) const
+	{
+		const auto find = objectName.find(name);
+
+		return find == objectName.end() ? nullptr : &object[find->second];
+	}
+
+	inline const Group* Hierarchy::findGroup(const std::string& name) const
+	{
+		const auto find = groupName.find(name);
+
+		return find == groupName.end() ? nullptr : &group[find->second];
+	}
+
+	// Copies the faces in the ranges from source to target, vertex/texture/normal lists are shared
+	inline size_t extract(const Face& source, const std::vector<Range>& ranges, Face& target)
+	{
+		std::vector<size_t> vertex, texture, normal;
+
+		offsets(source.vertex, vertex);
+		offsets(source.texture, texture);
+		offsets(source.normal, normal);
+
+		auto copy = [](const List<int>& from, const std::vector<size_t>& offset, const Range& range, List<int>& to)
+		{
+			const auto end = std::min(range.end, from.size());
+
+			if (range.begin >= end) return;
+
+			to.v.insert(to.v.end(), from.v.begin() + offset[range.begin], from.v.begin() + offset[end]);
+			to.s.insert(to.s.end(), from.s.begin() + range.begin, from.s.begin() + end);
+		};
+
+		for (const auto& range : ranges)
+		{
+			copy(source.vertex, vertex, range, target.vertex);
+			copy(source.texture, texture, range, target.texture);
+			copy(source.normal, normal, range, target.normal);
+		}
+
+		return target.vertex.size();
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+
+	inline size_t createMemory(FILE* file, char*& memory, size_t& size, std::vector<size_t>& continuation)
+	{
+		if (file == nullptr || size == 0)
+			return 0;
+
+		memory = new char[size + 1];
+
+		if (memory == nullptr)
+			return 0;
+
+		size = fread(memory, sizeof(char), size, file);
+
+		return createRows(memory, size, continuation);
+	}
+
+	inline size_t createMemory(const char* data, char*& memory, const size_t size, std::vector<size_t>& continuation)
+	{
+		if (data == nullptr || size == 0)
+			return 0;
+
+		memory = new char[size + 1];
+
+		if (memory == nullptr)
+			return 0;
+
+		memcpy(memory, data, size);
+
+		return createRows(memory, size, continuation);
+	}
+
+	// Rows end at newline, continuation gets the offset of each newline joined into a row so errors can be reported at the line in the file
+	inline size_t createRows(char*& memory, const size_t size, std::vector<size_t>& continuation)
+	{
+		size_t rows(0);
+
+		continuation.clear();
+
+		for (size_t i = 0; i < size; i++)
+		{
+			if (memory[i] == '\n')
+			{
+				if (i > 0 && (memory[i - 1] == '\\' || (memory[i - 1] == '\r' && i > 1 && memory[i - 2] == '\\')))
+				{
+					join(memory, i); //Line continuation, the next line belongs to this row
+
+					continuation.push_back(i);
+
+					continue;
+				}
+
+				rows++;
+
+				memory[i] = '\0';
+			}
+			else if (memory[i] == '\0') //A stray zero byte would otherwise split a row
+				memory[i] = ' ';
+		}
+
+		rows++;
+
+		memory[size] = '\0'; //EOF
+
+		if (rows == 0)
+		{
+			delete[] memory;
+
+			memory = nullptr;
+		}
+
+		return memory ? rows : 0;
+	}
+
+	inline void join(char* memory, size_t newline) //Backslash, carriage return and newline become spaces
+	{
+		memory[newline] = ' ';
+
+		while (memory[--newline] != '\\')
+			memory[newline] = ' ';
+
+		memory[newline] = ' ';
+	}
+
+	inline bool createDocument(char*& memory, const size_t size, char**& document, const size_t rows)
+	{
+		if (size == 0 || rows == 0)
+			return false;
+
+		document = new char* [rows];
+
+		if (document == nullptr)
+			return false;
+
+		document[0] = &memory[0];
+
+		size_t row(1);
+
+		for (size_t i = 0; i < size && row < rows; i++)
+		{
+			if (memory[i] == '\0')
+			{
+				document[row] = &memory[i + 1]; //memory[size] = EOF (see above)
+
+				row++;
+			}
+		}
+
+		if (row != rows)
+		{
+			delete[] document;
+
+			document = nullptr;
+		}
+
+		return document ? true : false;
+	}
+
+	inline bool validNumber(const std::string& token) //The scanner of the parser, not the locale dependent ::strtod
+	{
+		const char* end = nullptr;
+
+		float value;
+
+		return strtof(token.c_str(), value, end) && *end == '\0';
+	}
+
+	inline bool validIndex(const std::string& token) //v, v/vt, v//vn or v/vt/vn, indices are not zero
+	{
+		size_t first(0), part(0);
+
+		while (first <= token.size())
+		{
+			const auto last = std::min(token.find('/', first), token.size());
+
+			const auto text = token.substr(first, last - first);
+
+			char* end = nullptr;
+
+			const auto value = strtol(text.c_str(), &end, 10);
+
+			if (text.empty() ? part != 1 || last == token.size() : *end != '\0' || value == 0 || value != static_cast<int>(value))
+				return false;
+
+			if (++part > 3)
+				return false;
+
+			first = last + 1;
+		}
+
+		return true;
+	}
+
+	// Called on the failure path only, the row is scanned again to find the offending token
+	inline void diagnose(const char* row, const char* line, const size_t number, Error& error)
+	{
+		const auto element = (*line == 'f' || *line == 'l' || *line == 'p') && isspace(*(line + 1));
+
+		const auto vertex = *line == 'v' && (isspace(*(line + 1)) || ((*(line + 1) == 't' || *(line + 1) == 'n') && isspace(*(line + 2))));
+
+		error.code = syntaxError;
+		error.row = number + 1;
+		error.column = static_cast<size_t>(line - row) + 1;
+		error.token = line;
+
+		while (!error.token.empty() && std::isspace(static_cast<unsigned char>(error.token.back())))
+			error.token.pop_back();
+
+		if (!element && !vertex)
+			return;
+
+		const char* p = line;
+
+		while (*p && !std::isspace(static_cast<unsigned char>(*p))) p++; //Keyword
+
+		while (*p)
+		{
+			while (std::isspace(static_cast<unsigned char>(*p))) p++;
+
+			if (*p == '\0') break;
+
+			const char* begin = p;
+
+			while (*p && !std::isspace(static_cast<unsigned char>(*p))) p++;
+
+			const std::string token(begin, p);
+
+			if (element ? validIndex(token) : validNumber(token))
+				continue;
+
+			error.code = element ? indexError : numberError;
+			error.column = static_cast<size_t>(begin - row) + 1;
+			error.token = token;
+
+			return;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+
+	inline bool strtoi(const char* text, int& i, const char*& end)
+	{
+		int v;
+
+		const char* p;
+
+		bool negative;
+
+		p = text;
+
+		negative = false;
+
+		while (*p == ' ' || *p == '\t') p++;
+
+		if (*p == '-')
+		{
+			negative = true;
+
+			p++;
+		}
+		else if (*p == '+')
+			p++;
+
+		const char* digits = p;
+
+		v = 0;
+
+		while (*p >= '0' && *p <= '9')
+		{
+			if (v > (std::numeric_limits<int>::max() - (*p - '0')) / 10) //Overflow
+				return false;
+
+			v = (v * 10) + (*p - '0');
+
+			p++;
+		}
+
+		end = p;
+
+		i = negative ? -v : v;
+
+		return p != digits; //A sign alone is not a number
+	}
+
+	inline double power10(const int exponent)
+	{
+		static const double exact[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		                                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+		return exponent <= 22 ? exact[exponent] : std::pow(10.0, exponent);
+	}
+
+	// Digits are collected as an integer and scaled once, so values written with up to 9 significant digits read back exactly
+	inline bool strtof(const char* text, float& d, const char*& end)
+	{
+		const char* p;
+
+		unsigned long long mantissa;
+
+		int exponent, scale;
+
+		bool negExp;
+
+		bool negative;
+
+		p = text;
+
+		negative = false;
+
+		while (*p == ' ' || *p == '\t') ++p;
+
+		if (*p == '-')
+		{
+			negative = true;
+
+			p++;
+		}
+		else if (*p == '+')
+			p++;
+
+		mantissa = 0;
+
+		scale = 0;
+
+		const char* digits = p;
+
+		while (*p >= '0' && *p <= '9')
+		{
+			if (mantissa < 100000000000000000ull)
+				mantissa = mantissa * 10 + static_cast<unsigned long long>(*p - '0');
+			else
+				scale++;
+
+			p++;
+		}
+
+		if (*p == '.')
+		{
+			p++;
+
+			while (*p >= '0' && *p <= '9')
+			{
+				if (mantissa < 100000000000000000ull)
+				{
+					mantissa = mantissa * 10 + static_cast<unsigned long long>(*p - '0');
+
+					scale--;
+				}
+
+				p++;
+			}
+		}
+
+		if (p == digits || (p == digits + 1 && *digits == '.')) //No digits
+			return false;
+
+		if ((*p == 'e' || *p == 'E') && ((*(p + 1) >= '0' && *(p + 1) <= '9') || ((*(p + 1) == '-' || *(p + 1) == '+') && *(p + 2) >= '0' && *(p + 2) <= '9')))
+		{
+			++p;
+
+			exponent = 0;
+
+			negExp = false;
+
+			if (*p == '-')
+			{
+				negExp = true;
+
+				p++;
+			}
+			else if (*p == '+')
+			{
+				p++;
+			}
+
+			while (*p >= '0' && *p <= '9')
+			{
+				if (exponent < 10000)
+					exponent = exponent * 10 + (*p - '0');
+
+				p++;
+			}
+
+			scale += negExp ? -exponent : exponent;
+		}
+
+		double v = static_cast<double>(mantissa);
+
+		if (mantissa != 0 && scale != 0)
+			v = scale < 0 ? v / power10(-scale) : v * power10(scale);
+
+		end = p;
+
+		d = static_cast<float>(negative ? -v : v);
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+
+	inline bool isspace(const char& c)
+	{
+		return c == ' ' || c == '\t' || c == '\v';
+	}
+
+	inline unsigned int lineOption(const char* line)
+	{
+		switch (*line)
+		{
+		case 'f': return positions;
+		case 'v': return *(line + 1) == 't' ? textures : *(line + 1) == 'n' ? normals : *(line + 1) == 'p' ? freeform : positions;
+		case '#':
+		case 'o':
+		case 'g': return metadata;
+		case 's': return isspace(*(line + 1)) || iseol(*(line + 1)) ? metadata : freeform; //Not surf, sp
+		case 'u': return keyword(line, "usemtl") ? materials : freeform;
+		case 'm': return keyword(line, "mtllib") ? materials : freeform;
+		case 'l':
+		case 'p': return isspace(*(line + 1)) ? elements : freeform; //Not lod, parm
+		case 'b':
+		case 'c':
+		case 'd':
+		case 'e':
+		case 'h':
+		case 't': return freeform;
+		}
+
+		return 0;
+	}
+
+	inline char* trim(char* p)
+	{
+		static char* e;
+
+		if (p == nullptr) return nullptr;
+
+		while (std::isspace(*p) && *p != '\0') p++;
+
+		e = p;
+
+		while (*e != '\0') e++;
+
+		while (e != p && std::isspace(*(e - 1))) e--;
+
+		*e = '\0';
+
+		return p;
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+
+	inline bool parse(char* line, std::string& file)
+	{
+		line++; // 'm'
+
+		if (*line++ != 't') return false;
+		if (*line++ != 'l') return false;
+		if (*line++ != 'l') return false;
+		if (*line++ != 'i') return false;
+		if (*line++ != 'b') return false;
+
+		file = trim(line);
+
+		return true;
+	}
+
+	inline bool parse(char* line, std::vector<std::tuple<std::string, size_t>>& list, const size_t face)
+	{
+		line++; // 'u'
+
+		if (*line++ != 's') return false;
+		if (*line++ != 'e') return false;
+		if (*line++ != 'm') return false;
+		if (*line++ != 't') return false;
+		if (*line++ != 'l') return false;
+
+		list.emplace_back(trim(line), face);
+
+		return true;
+	}
+
+	inline bool parse(char* line, std::vector<std::tuple<char, std::string, size_t>>& information, const size_t face)
+	{
+		information.emplace_back(*line, trim(line + 1), face);
+
+		return true;
+	}
+
+	inline bool parse(char* line, std::vector<std::tuple<std::string, std::string, size_t>>& records, const size_t face)
+	{
+		char* end = line;
+
+		while (*end != '\0' && !std::isspace(static_cast<unsigned char>(*end))) end++;
+
+		records.emplace_back(std::string(line, end), trim(end), face);
+
+		return true;
+	}
+
+	inline bool keyword(const char* line, const char* word)
+	{
+		while (*word != '\0')
+		{
+			if (*line++ != *word++)
+				return false;
+		}
+
+		return *line == '\0' || std::isspace(static_cast<unsigned char>(*line));
+	}
+
+	inline bool parse(const char* line, Vertex& item)
+	{
+		static std::vector<float> vertex(6);
+
+		if (!strtof(line, vertex[0], line))
+			return false;
+
+		if (!strtof(line, vertex[1], line))
+			return false;
+
+		if (!strtof(line, vertex[2], line))
+			return false;
+
+		if (!strtof(line, vertex[3], line))
+		{
+			item.insert(vertex.begin(), vertex.begin() + 3); //x, y, z
+
+			return true;
+		}
+
+		if (!strtof(line, vertex[4], line))
+		{
+			item.insert(vertex.begin(), vertex.begin() + 4); //x, y, z, w
+
+			return true;
+		}
+
+		if (!strtof(line, vertex[5], line))
+			return false;
+
+		item.insert(vertex); //x, y, z, r, g, b
+
+		return true;
+	}
+
+	inline bool parse(const char* line, Normal& item)
+	{
+		static std::vector<float> normal(3);
+
+		if (!strtof(line, normal[0], line))
+			return false;
+
+		if (!strtof(line, normal[1], line))
+			return false;
+
+		if (!strtof(line, normal[2], line))
+			return false;
+
+		item.insert(normal);
+
+		return true;
+	}
+
+	inline bool parse(const char* line, Texture& item)
+	{
+		static std::vector<float> texture(3);
+
+		if (!strtof(line, texture[0], line))
+			return false;
+
+		if (!strtof(line, texture[1], line))
+		{
+			item.insert(texture.begin(), texture.begin() + 1);
+
+			return true;
+		}
+
+		if (!strtof(line, texture[2], line))
+		{
 			item.insert(texture.begin(), texture.begin() + 2);
 
-			return true;
+			return true;
+		}
+
+		item.insert(texture);
+
+		return true;
+	}
+
+	inline bool parse(const char* line, Parameter& item)
+	{
+		static std::vector<float> parameter(3);
+
+		if (!strtof(line, parameter[0], line))
+			return false;
+
+		if (!strtof(line, parameter[1], line))
+		{
+			item.insert(parameter.begin(), parameter.begin() + 1); //u
+
+			return true;
+		}
+
+		if (!strtof(line, parameter[2], line))
+		{
+			item.insert(parameter.begin(), parameter.begin() + 2); //u, v
+
+			return true;
+		}
+
+		item.insert(parameter); //u, v, w
+
+		return true;
+	}
+
+	inline bool iseol(const char& c)
+	{
+		return c == '\r' || c == '\n' || c == '\0';
+	}
+
+	inline bool parse(const char* line, Point& item)
+	{
+		static int i;
+
+		static std::vector<int> vertex;
+
+		vertex.clear();
+
+		while (!iseol(*line))
+		{
+			if (!strtoi(line, i, line) || i == 0)
+				return false;
+
+			i = i > 0 ? i - 1 : i; //Negative indices are resolved after parsing
+
+			vertex.push_back(i);
+
+			while (isspace(*line))
+				line++;
+		}
+
+		item.vertex.insert(vertex);
+
+		return true;
+	}
+
+	inline bool parse(const char* line, Line& item, const unsigned int options)
+	{
+		static int i;
+
+		static std::vector<int> vertex;
+		static std::vector<int> texture;
+
+		vertex.clear();
+		texture.clear();
+
+		while (!iseol(*line))
+		{
+			if (!strtoi(line, i, line) || i == 0)
+				return false;
+
+			i = i > 0 ? i - 1 : i; //Negative indices are resolved after parsing
+
+			vertex.push_back(i);
+
+			if (*line == '/')
+			{
+				line++;
+
+				if (!strtoi(line, i, line) || i == 0)
+					return false;
+
+				i = i > 0 ? i - 1 : i; //Negative indices are resolved after parsing
+
+				texture.push_back(i);
+			}
+
+			while (isspace(*line))
+				line++;
+		}
+
+		item.vertex.insert(vertex);
+
+		if (options & textures)
+			item.texture.insert(texture);
+
+		return true;
+	}
+
+	inline bool parse(const char* line, Face& item, bool triangulate, const unsigned int options)
+	{
+		static int i;
+
+		static std::vector<int> vertex;
+		static std::vector<int> texture;
+		static std::vector<int> normal;
+
+		vertex.clear();
+		texture.clear();
+		normal.clear();
+
+		while (!iseol(*line))
+		{
+			if (!strtoi(line, i, line) || i == 0)
+				return false;
+
+			i = i > 0 ? i - 1 : i; //Negative indices are resolved after parsing
+
+			vertex.emplace_back(i);
+
+			if (*line == '/')
+			{
+				line++;
+
+				if (*line != '/')
+				{
+					if (!strtoi(line, i, line) || i == 0)
+						return false;
+
+					i = i > 0 ? i - 1 : i; //Negative indices are resolved after parsing
+
+					texture.emplace_back(i);
+				}
+
+				if (*line == '/')
+				{
+					line++;
+
+					if (!strtoi(line, i, line) || i == 0)
+						return false;
+
+					i = i > 0 ? i - 1 : i; //Negative indices are resolved after parsing
+
+					normal.emplace_back(i);
+				}
+			}
+
+			while (isspace(*line))
+				line++;
+		}
+
+		insert_indices(item.vertex, vertex, vertex.size(), triangulate);
+		if (options & textures)
+			insert_indices(item.texture, texture, vertex.size(), triangulate);
+
+		if (options & normals)
+			insert_indices(item.normal, normal, vertex.size(), triangulate);
+
+		return true;
+	}
+
+	inline void insert_indices(List<int>& list, const std::vector<int>& indices, const size_t corners, bool triangulate)
+	{
+		if (triangulate && corners > 3)
+		{
+			if (indices.size() == corners)
+				triangulate_indices(list, indices);
+			else
+				list.s.insert(list.s.end(), corners - 2, 0); //Keep one (empty) entry per triangle
+		}
+		else
+			list.insert(indices);
+	}
+
+	inline void triangulate_indices(List<int>& list, const std::vector<int>& indices)
+	{
+		static size_t size, index;
+
+		size = indices.size();
+
+		static std::vector<int> triangle;
+
+		for (index = 0; index < size - 2; index++)
+		{
+			triangle.clear();
+
+			triangle.push_back(indices[index + 1]);
+			triangle.push_back(indices[index + 2]);
+			triangle.push_back(indices[0]);
+
+			list.insert(triangle);
+		}
+	}
+
+	// Negative indices are relative to the count in the segment of their corner, segments are (first corner, count) in corner order
+	// Returns the first corner out of range, or the size if all are valid. Indices out of range are not changed
+	// With concurrent the chunks are spread over all hardware threads, otherwise they run on the calling thread
+	inline size_t resolve(std::vector<int>& index, const std::vector<std::pair<size_t, int>>& segment, const int total, const bool concurrent)
+	{
+		const size_t grain = 1 << 16;
+
+		const size_t chunks = (index.size() + grain - 1) / grain;
+
+		std::vector<size_t> invalid(chunks, index.size()); //First corner out of range per chunk
+
+		auto work = [&](const size_t begin, const size_t end)
+		{
+			for (size_t chunk = begin; chunk < end; chunk++)
+			{
+				const auto first = chunk * grain;
+
+				const auto last = std::min(first + grain, index.size());
+
+				auto next = std::upper_bound(segment.begin(), segment.end(), first, [](const size_t corner, const std::pair<size_t, int>& item) { return corner < item.first; });
+
+				auto count = next == segment.begin() ? 0 : (next - 1)->second;
+
+				for (size_t corner = first; corner < last; corner++)
+				{
+					while (next != segment.end() && next->first <= corner)
+						count = (next++)->second;
+
+					const auto item = index[corner] < 0 ? index[corner] + count : index[corner];
+
+					if (item >= 0 && item < total)
+						index[corner] = item;
+					else if (invalid[chunk] == index.size()) //Left as written
+						invalid[chunk] = corner;
+				}
+			}
+		};
+
+		if (concurrent)
+			parallel(chunks, 1, work);
+		else
+			work(0, chunks);
+
+		return chunks ? *std::min_element(invalid.begin(), invalid.end()) : index.size();
+	}
+
+	// Removes the elements with an index out of range from lists that share the element order, an empty list is left empty
+	// A list with a negative total is not checked
+	// kept[element] is set to the elements kept before element, for element 0 to size. Returns the elements removed
+	inline size_t removeInvalid(List<int>* const* list, const int* total, const size_t count, std::vector<size_t>& kept)
+	{
+		size_t elements(0);
+
+		for (size_t item = 0; item < count; item++)
+			elements = std::max(elements, list[item]->size());
+
+		kept.assign(elements + 1, 0);
+
+		std::vector<size_t> read(count, 0), write(count, 0);
+
+		size_t size(0);
+
+		for (size_t element = 0; element < elements; element++)
+		{
+			auto valid(true);
+
+			for (size_t item = 0; item < count && valid; item++)
+			{
+				if (list[item]->s.empty()) continue;
+
+				const auto first = list[item]->v.begin() + static_cast<std::ptrdiff_t>(read[item]);
+
+				valid = std::all_of(first, first + list[item]->s[element], [&](const int index) { return total[item] < 0 || (index >= 0 && index < total[item]); });
+			}
+
+			for (size_t item = 0; item < count; item++)
+			{
+				if (list[item]->s.empty()) continue;
+
+				const auto corners = static_cast<size_t>(list[item]->s[element]);
+
+				if (valid)
+				{
+					auto& v = list[item]->v;
+
+					std::copy(v.begin() + static_cast<std::ptrdiff_t>(read[item]), v.begin() + static_cast<std::ptrdiff_t>(read[item] + corners), v.begin() + static_cast<std::ptrdiff_t>(write[item]));
+
+					list[item]->s[size] = list[item]->s[element];
+
+					write[item] += corners;
+				}
+
+				read[item] += corners;
+			}
+
+			if (valid)
+				size++;
+
+			kept[element + 1] = size;
+		}
+
+		for (size_t item = 0; item < count; item++)
+		{
+			if (list[item]->s.empty()) continue;
+
+			list[item]->v.resize(write[item]);
+
+			list[item]->s.resize(size);
+		}
+
+		return elements - size;
+	}
+
+	// <-------- End of WavefrontOBJ.h 
+
+	//-------------------------------------------------------------------------------------------------------
+	// Additional functions to simplify the connection between each face and material/color (Kd)
+	//-------------------------------------------------------------------------------------------------------
+
+	struct Submesh
+	{
+		std::string        material; //usemtl name, empty for faces before the first usemtl
+		int                index;    //Material index in the mtl file, -1 if unknown
+		std::vector<Range> face;     //Face ranges using the material
+		std::vector<Range> corner;   //The same ranges as offsets in face.vertex.v
+	};
+
+	// One submesh per material (first usemtl order) with contiguous face ranges, no per face array
+	inline size_t submesh(Load& loadOBJ, std::vector<Submesh>& list)
+	{
+		list.clear();
+
+		const auto faces = loadOBJ.face.vertex.size();
+
+		if (faces == 0) return 0;
+
+		const auto& materialFace = loadOBJ.usemtl();
+
+		const auto& size = loadOBJ.face.vertex.s;
+
+		const auto triangles = std::all_of(size.begin(), size.end(), [](const int item) { return item == 3; });
+
+		std::unordered_map<std::string, size_t> materialSubmesh;
+
+		size_t face(0), corner(0);
+
+		auto cornerOffset = [&](const size_t to) //Faces are visited once in increasing order
+		{
+			if (triangles)
+				return to * 3;
+
+			for (; face < to; face++)
+				corner += size[face];
+
+			return corner;
+		};
+
+		auto append = [&](const std::string& material, const size_t begin, const size_t end)
+		{
+			if (begin >= end) return;
+
+			const auto find = materialSubmesh.emplace(material, list.size());
+
+			if (find.second)
+				list.push_back(Submesh{ material, -1, {}, {} });
+
+			auto& item = list[find.first->second];
+
+			const Range corners{ cornerOffset(begin), cornerOffset(end) };
+
+			if (!item.face.empty() && item.face.back().end == begin)
+			{
+				item.face.back().end = end;
+				item.corner.back().end = corners.end;
+			}
+			else
+			{
+				item.face.push_back(Range{ begin, end });
+				item.corner.push_back(corners);
+			}
+		};
+
+		append(std::string(), 0, materialFace.empty() ? faces : std::min(std::get<1>(materialFace.front()), faces));
+
+		for (size_t index = 0; index < materialFace.size(); index++)
+		{
+			const auto begin = std::min(std::get<1>(materialFace[index]), faces);
+			const auto end = index + 1 < materialFace.size() ? std::min(std::get<1>(materialFace[index + 1]), faces) : faces;
+
+			append(std::get<0>(materialFace[index]), begin, end);
+		}
+
+		return list.size();
+	}
+
+	template <typename LoadMTL>
+	size_t submesh(Load& loadOBJ, LoadMTL& loadMTL, std::vector<Submesh>& list)
+	{
+		if (submesh(loadOBJ, list) == 0) return 0;
+
+		auto& materials = loadMTL.materials();
+
+		std::unordered_map<std::string, int> materialNameIndex;
+
+		for (size_t index = 0; index < materials.size(); index++)
+			materialNameIndex.emplace(materials[index].name, static_cast<int>(index));
+
+		for (auto& item : list)
+		{
+			const auto find = materialNameIndex.find(item.material);
+
+			item.index = find == materialNameIndex.end() ? -1 : find->second;
+		}
+
+		return list.size();
+	}
+
+	template <typename LoadMTL>
+	size_t connectFaceMaterial(Load& loadOBJ, LoadMTL& loadMTL, std::vector<int>& connect)
+	{
+		size_t lastFace;
+
+		connect.clear();
+
+		auto& materials = loadMTL.materials();
+
+		if (materials.size() == 0) return 0;
+
+		if (loadOBJ.face.vertex.empty()) return 0;
+
+		std::unordered_map<std::string, int> materialNameIndex;
+
+		for (size_t index = 0; index < materials.size(); index++)
+			materialNameIndex.emplace(materials[index].name, static_cast<int>(index));
+
+		const auto& materialFace = loadOBJ.usemtl();
+
+		connect.reserve(loadOBJ.face.vertex.size());
+
+		for (size_t index = 0; index < materialFace.size(); index++)
+		{
+			const auto& item = materialFace[index];
+
+			const auto& material = std::get<0>(item);
+			const auto& fromFace = std::get<1>(item);
+
+			if (index == materialFace.size() - 1)
+				lastFace = loadOBJ.face.vertex.size();
+			else
+			{
+				const auto& next = materialFace[index + 1];
+
+				lastFace = std::get<1>(next);
+			}
+
+			const auto find = materialNameIndex.find(material);
+
+			const int materialIndex = find == materialNameIndex.end() ? -1 : find->second;
+
+			connect.insert(connect.end(), lastFace - fromFace, materialIndex);
+		}
+
+		if (connect.size() != loadOBJ.face.vertex.size())
+			connect.clear();
+
+		return connect.size();
+	}
+
+	template <typename LoadMTL, class T>
+	size_t loadFaceColor(Load& loadOBJ, LoadMTL& loadMTL, std::vector<std::vector<T>>& color, const bool alpha = false)
+	{
+		T r = 0;
+		T g = 0;
+		T b = 1;
+		T a = 1;
+
+		color.clear();
+
+		std::vector<int> faceMaterial;
+
+		auto& materialList = loadMTL.materials();
+
+		if (connectFaceMaterial(loadOBJ, loadMTL, faceMaterial) == 0)
+		{
+			std::vector<T> defaultColor;
+
+			if (!materialList.empty())
+			{
+				const auto& material = materialList[0];
+
+				const auto& Kd = material.Kd.color;
+
+				r = static_cast<T>(Kd.r);
+				g = static_cast<T>(Kd.g);
+				b = static_cast<T>(Kd.b);
+
+				if (alpha)
+					a = static_cast<T>(material.d.d);
+			}
+
+			if (alpha)
+				defaultColor = { r , g , b , a };
+			else
+				defaultColor = { r , g , b };
+
+			color = std::vector<std::vector<T>>(loadOBJ.face.vertex.size(), defaultColor);
+
+			return color.size();
+		}
+
+		color.resize(faceMaterial.size());
+
+		int materialIndex(-1);
+
+		for (size_t face = 0; face < color.size(); face++)
+		{
+			if (materialIndex != faceMaterial[face])
+			{
+				if (faceMaterial[face] != -1)
+				{
+					materialIndex = faceMaterial[face];
+
+					const auto& material = materialList[materialIndex];
+
+					const auto& Kd = material.Kd.color;
+
+					r = static_cast<T>(Kd.r);
+					g = static_cast<T>(Kd.g);
+					b = static_cast<T>(Kd.b);
+
+					if (alpha)
+						a = static_cast<T>(material.d.d);
+				}
+			}
+
+			if (alpha)
+				color[face] = { r , g , b , a };
+			else
+				color[face] = { r , g , b };
+		}
+
+		return color.size();
+	}
+
+	template <typename LoadMTL, class T>
+	size_t Copy(Load& loadOBJ, LoadMTL& loadMTL, std::vector<std::vector<T>>& color, const bool alpha = false)
+	{
+		return loadFaceColor(loadOBJ, loadMTL, color, alpha);
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+	// Additional functions for easier copying or moving of lists from WavefrontOBJ to your working lists
+	//-------------------------------------------------------------------------------------------------------
+
+	enum VertexFormat
+	{
+		xyz = 3,
+		xyzw = 4,
+		xyzrgb = 6
+	};
+
+	inline VertexFormat vertexFormat(const size_t& size)
+	{
+		switch(size)
+		{
+		case 3: return xyz;
+		case 4: return xyzw;
+		case 6: return xyzrgb;
+		}
+
+		return xyz;
+	}
+
+	inline VertexFormat format(const Vertex& vertex, bool& varies)
+	{
+		varies = false;
+
+		if (vertex.empty()) return xyz;
+
+		const VertexFormat format = vertexFormat(vertex.s.front());
+
+		for (const auto& size : vertex.s)
+		{
+			if (vertexFormat(size) != format)
+			{
+				varies = true;
+
+				return xyz;
+			}
+		}
+
+		return format;
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+	// Views over the lists without copying, only for lists where all items have N components
+	//-------------------------------------------------------------------------------------------------------
+
+	template <typename T, size_t N>
+	struct View
+	{
+		size_t size() const { return count; }
+
+		bool empty() const { return count == 0; }
+
+		const T* operator[](const size_t item) const { return data + item * N; }
+
+		const T& operator()(const size_t item, const size_t component) const { return data[item * N + component]; }
+
+		const T* data;
+		size_t   count;
+	};
+
+	// Empty view if not all items in the list have N components
+	template <size_t N, typename T>
+	View<T, N> view(const List<T>& list)
+	{
+		const auto uniform = std::all_of(list.s.begin(), list.s.end(), [](const int size) { return size == static_cast<int>(N); });
+
+		if (!uniform || list.empty())
+			return View<T, N>{ nullptr, 0 };
+
+		return View<T, N>{ list.v.data(), list.size() };
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+	// Item conversion, components missing in the source are 0 (texture w is 1)
+	//-------------------------------------------------------------------------------------------------------
+
+	// Components per item if all items have the same number of components, otherwise 0
+	template <typename T>
+	int arity(const List<T>& list)
+	{
+		if (list.empty()) return 0;
+
+		const auto size = list.s.front();
+
+		for (const auto& item : list.s)
+		{
+			if (item != size) return 0;
+		}
+
+		return size;
+	}
+
+	// Converts count items of From components to To components in one pass the compiler can vectorize. Components
+	// beyond x, y, z (u, v, w) are only taken from the source if From equals To, otherwise from fill.
+	template <int From, int To, typename T>
+	void convert(const float* source, const size_t count, const float* fill, T* target)
+	{
+		for (size_t item = 0; item < count; item++)
+		{
+			for (int component = 0; component < To; component++)
+				target[component] = static_cast<T>(component < From && (component < 3 || From == To) ? source[component] : fill[component]);
+
+			source += From;
+			target += To;
+		}
+	}
+
+	template <typename T>
+	void convert(const float* source, const size_t count, T* target)
+	{
+		for (size_t index = 0; index < count; index++)
+			target[index] = static_cast<T>(source[index]);
+	}
+
+	template <typename T>
+	void vertexItem(const float* source, const int size, const VertexFormat format, T* target)
+	{
+		target[0] = static_cast<T>(size > 0 ? source[0] : 0.0f);
+		target[1] = static_cast<T>(size > 1 ? source[1] : 0.0f);
+		target[2] = static_cast<T>(size > 2 ? source[2] : 0.0f);
+
+		for (int component = 3; component < format; component++) //w or rgb only from the same format, w defaults to 1
+			target[component] = static_cast<T>(size == format ? source[component] : format == xyzw ? 1.0f : 0.0f);
+	}
+
+	// Whole list conversion when all vertices have the same format, false if the scalar path is needed
+	template <typename T>
+	bool vertexList(const Vertex& source, const VertexFormat format, T* target)
+	{
+		static const float fillW[6] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+		static const float fillRGB[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+		const float* fill = format == xyzw ? fillW : fillRGB;
+
+		const float* v = source.v.data();
+
+		const auto count = source.size();
+
+		switch (arity(source) * 10 + format)
+		{
+		case 33: case 44: case 66: convert(v, source.v.size(), target); return true;
+		case 34: convert<3, 4>(v, count, fill, target); return true;
+		case 36: convert<3, 6>(v, count, fill, target); return true;
+		case 43: convert<4, 3>(v, count, fill, target); return true;
+		case 46: convert<4, 6>(v, count, fill, target); return true;
+		case 63: convert<6, 3>(v, count, fill, target); return true;
+		case 64: convert<6, 4>(v, count, fill, target); return true;
+		}
+
+		return false;
+	}
+
+	template <typename T>
+	void normalItem(const float* source, const int size, T* target)
+	{
+		target[0] = static_cast<T>(size > 0 ? source[0] : 0.0f);
+		target[1] = static_cast<T>(size > 1 ? source[1] : 0.0f);
+		target[2] = static_cast<T>(size > 2 ? source[2] : 0.0f);
+	}
+
+	// Copies to a caller provided buffer of capacity items, returns the number of items or 0 if the buffer is too small
+	template <typename T>
+	size_t copy(const Vertex& source, T* target, const size_t capacity, const VertexFormat format = xyz)
+	{
+		if (capacity < source.size()) return 0;
+
+		if (vertexList(source, format, target))
+			return source.size();
+
+		const float* vertex = source.v.data();
+
+		for (const auto& size : source.s)
+		{
+			vertexItem(vertex, size, format, target);
+
+			target += format;
+			vertex += size;
+		}
+
+		return source.size();
+	}
+
+	inline bool move(Vertex& source, std::vector<float>& target, const VertexFormat format = xyz)
+	{
+		bool varies(false);
+
+		if (source.empty()) return true;
+
+		if (obj::format(source, varies) == format && !varies)
+		{
+			target = std::move(source.v);
+
+			source.clear();
+
+			return true;
+		}
+
+		return false;
+	}
+
+	template <typename T>
+	size_t copy(const Vertex& source, std::vector<T>& target, const VertexFormat format = xyz)
+	{
+		const auto offset = target.size();
+
+		target.resize(offset + source.size() * format);
+
+		copy(source, target.data() + offset, source.size(), format);
+
+		return target.size();
+	}
+
+	inline size_t copy(Vertex& source, std::vector<float>& target, const VertexFormat format = xyz)
+	{
+		if(move(source, target, format))
+			return target.size();
+
+		return copy(static_cast<const Vertex&>(source), target, format);
+	}
+
+	template <typename T>
+	size_t copy(const Vertex& source, std::vector<std::vector<T>>& target, const VertexFormat format = xyz)
+	{
+		target.reserve(target.size() + source.size());
+
+		const float* vertex = source.v.data();
+
+		for (const auto& size : source.s)
+		{
+			target.emplace_back(static_cast<size_t>(format));
+
+			vertexItem(vertex, size, format, target.back().data());
+
+			vertex += size;
+		}
+
+		return target.size();
+	}
+
+	template <typename T>
+	size_t copy(const Normal& source, T* target, const size_t capacity)
+	{
+		if (capacity < source.size()) return 0;
+
+		if (arity(source) == 3)
+		{
+			convert(source.v.data(), source.v.size(), target);
+
+			return source.size();
+		}
+
+		const float* normal = source.v.data();
+
+		for (const auto& size : source.s)
+		{
+			normalItem(normal, size, target);
+
+			target += 3;
+			normal += size;
+		}
+
+		return source.size();
+	}
+
+	inline bool move(Normal& source, std::vector<float>& target)
+	{
+		if (source.empty()) return true;
+
+		for (const auto& size : source.s)
+		{
+			if (size != xyz)
+				return false;
+		}
+
+		target = std::move(source.v);
+
+		source.clear();
+
+		return true;
+	}
+
+	template <typename T>
+	size_t copy(const Normal& source, std::vector<T>& target)
+	{
+		const auto offset = target.size();
+
+		target.resize(offset + source.size() * 3);
+
+		copy(source, target.data() + offset, source.size());
+
+		return target.size();
+	}
+
+	inline size_t copy(Normal& source, std::vector<float>& target)
+	{
+		if (move(source, target))
+			return target.size();
+
+		return copy(static_cast<const Normal&>(source), target);
+	}
+
+	template <typename T>
+	size_t copy(const Normal& source, std::vector<std::vector<T>>& target)
+	{
+		target.reserve(target.size() + source.size());
+
+		const float* normal = source.v.data();
+
+		for (const auto& size : source.s)
+		{
+			target.emplace_back(static_cast<size_t>(3));
+
+			normalItem(normal, size, target.back().data());
+
+			normal += size;
+		}
+
+		return target.size();
+	}
+
+	enum TextureFormat
+	{
+		uv = 2,
+		uvw = 3
+	};
+
+	inline TextureFormat textureFormat(const size_t& size)
+	{
+		return size == 2 ? uv : uvw;
+	}
+
+	inline TextureFormat format(const Texture& texture, bool& varies)
+	{
+		varies = false;
+
+		if (texture.empty()) return uv;
+
+		const TextureFormat format = textureFormat(texture.s.front());
+
+		for (const auto& size : texture.s)
+		{
+			if (textureFormat(size) != format)
+			{
+				varies = true;
+
+				return uv;
+			}
+		}
+
+		return format;
+	}
+
+	template <typename T>
+	void textureItem(const float* source, const int size, const TextureFormat format, T* target)
+	{
+		target[0] = static_cast<T>(size > 0 ? source[0] : 0.0f);
+		target[1] = static_cast<T>(size > 1 ? source[1] : 0.0f);
+
+		if (format == uvw)
+			target[2] = static_cast<T>(size > 2 ? source[2] : 1.0f);
+	}
+
+	template <typename T>
+	size_t copy(const Texture& source, T* target, const size_t capacity, const TextureFormat format = uvw)
+	{
+		if (capacity < source.size()) return 0;
+
+		static const float fill[3] = { 0.0f, 0.0f, 1.0f };
+
+		const float* v = source.v.data();
+
+		switch (arity(source) * 10 + format)
+		{
+		case 22: case 33: convert(v, source.v.size(), target); return source.size();
+		case 23: convert<2, 3>(v, source.size(), fill, target); return source.size();
+		case 32: convert<3, 2>(v, source.size(), fill, target); return source.size();
+		}
+
+		const float* texture = source.v.data();
+
+		for (const auto& size : source.s)
+		{
+			textureItem(texture, size, format, target);
+
+			target += format;
+			texture += size;
+		}
+
+		return source.size();
+	}
+
+	inline bool move(Texture& source, std::vector<float>& target, const TextureFormat format = uvw)
+	{
+		bool varies(false);
+
+		if (source.empty()) return true;
+
+		if (obj::format(source, varies) == format && !varies)
+		{
+			target = std::move(source.v);
+
+			source.clear();
+
+			return true;
+		}
+
+		return false;
+	}
+
+	template <typename T>
+	size_t copy(const Texture& source, std::vector<T>& target, const TextureFormat format = uvw)
+	{
+		const auto offset = target.size();
+
+		target.resize(offset + source.size() * format);
+
+		copy(source, target.data() + offset, source.size(), format);
+
+		return target.size();
+	}
+
+	inline size_t copy(Texture& source, std::vector<float>& target, const TextureFormat format = uvw)
+	{
+		if (move(source, target, format))
+			return target.size();
+
+		return copy(static_cast<const Texture&>(source), target, format);
+	}
+
+	template <typename T>
+	size_t copy(const Texture& source, std::vector<std::vector<T>>& target, const TextureFormat format = uvw)
+	{
+		target.reserve(target.size() + source.size());
+
+		const float* texture = source.v.data();
+
+		for (const auto& size : source.s)
+		{
+			target.emplace_back(static_cast<size_t>(format));
+
+			textureItem(texture, size, format, target.back().data());
+
+			texture += size;
+		}
+
+		return target.size();
+	}
+
+	inline bool move(List<int>& source, std::vector<int>& target)
+	{
+		if (source.empty()) return true;
+
+		target = std::move(source.v);
+
+		source.clear();
+
+		return true;
+	}
+
+	inline size_t copy(List<int>& source, std::vector<int>& target)
+	{
+		return move(source, target) ? target.size() : 0;
+	}
+
+	inline size_t copy(const List<int>& source, std::vector<std::vector<int>>& target)
+	{
+		target.reserve(target.size() + source.size());
+
+		auto item = source.v.begin();
+
+		for (const auto& size : source.s)
+		{
+			target.emplace_back(item, item + size);
+
+			item += size;
+		}
+
+		return target.size();
+	}
+
+	enum IndexWidth
+	{
+		index16 = 16,
+		index32 = 32
+	};
+
+	// 0xFFFF and 0xFFFFFFFF are left free for primitive restart
+	inline IndexWidth indexWidth(const size_t count)
+	{
+		return count < 0xFFFF ? index16 : index32;
+	}
+
+	inline IndexWidth indexWidth(const Load& loadOBJ)
+	{
+		return indexWidth(std::max(loadOBJ.vertex.size(), std::max(loadOBJ.texture.size(), loadOBJ.normal.size())));
+	}
+
+	// Copies the indices to an unsigned index list (uint16_t or uint32_t). Returns false, with an empty target,
+	// if an index is negative, not below count (the number of parsed items) or does not fit in T.
+	template <typename T>
+	bool copy(const List<int>& source, std::vector<T>& target, const size_t count)
+	{
+		static_assert(std::is_unsigned<T>::value, "Index type must be unsigned");
+
+		target.clear();
+
+		const auto maximum = static_cast<unsigned long long>(std::numeric_limits<T>::max()); //Not max() + 1, that wraps to 0 for 64 bit T
+
+		unsigned long long overflow(0);
+
+		for (const auto& index : source.v)
+		{
+			const auto value = static_cast<unsigned long long>(static_cast<unsigned int>(index));
+
+			overflow |= (value >= count || value > maximum) ? 1 : 0;
+		}
+
+		if (overflow) return false;
+
+		target.resize(source.v.size());
+
+		for (size_t index = 0; index < source.v.size(); index++)
+			target[index] = static_cast<T>(source.v[index]);
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+	// Additional functions for reordering faces and vertices for the GPU vertex cache and vertex fetch
+	//-------------------------------------------------------------------------------------------------------
+
+	struct CacheStatistics
+	{
+		double acmr; //Average cache miss ratio, transformed vertices per triangle
+		double atvr; //Average transformed vertex ratio, transformed vertices per referenced vertex
+	};
+
+	// Rebuilds the list from the items in order, order may also select a subset of the items
+	template <typename T>
+	void reorder(List<T>& list, const std::vector<size_t>& order)
+	{
+		if (list.empty()) return; //Not loaded, see LoadOption
+
+		std::vector<size_t> offset;
+
+		offsets(list, offset);
+
+		std::vector<T>   v;
+		std::vector<int> s;
+
+		v.reserve(list.v.size());
+		s.reserve(list.s.size());
+
+		for (const auto& index : order)
+		{
+			v.insert(v.end(), list.v.begin() + offset[index], list.v.begin() + offset[index + 1]);
+			s.emplace_back(list.s[index]);
+		}
+
+		list.v.swap(v);
+		list.s.swap(s);
+	}
+
+	inline void remap(List<int>& list, const std::vector<int>& remap)
+	{
+		for (auto& index : list.v)
+		{
+			if (index >= 0 && static_cast<size_t>(index) < remap.size())
+				index = remap[index];
+		}
+	}
+
+	inline CacheStatistics cacheStatistics(const Face& face, const size_t vertexCount, const size_t cacheSize = 16)
+	{
+		CacheStatistics statistics{ 0.0, 0.0 };
+
+		if (face.vertex.empty() || vertexCount == 0 || cacheSize == 0)
+			return statistics;
+
+		std::vector<size_t> timestamp(vertexCount, 0);
+
+		size_t time(cacheSize + 1), misses(0), triangles(0), referenced(0);
+
+		auto index = face.vertex.v.begin();
+
+		for (const auto& size : face.vertex.s)
+		{
+			for (int corner = 0; corner < size; corner++)
+			{
+				const auto vertex = *(index + corner);
+
+				if (vertex < 0 || static_cast<size_t>(vertex) >= vertexCount)
+					continue;
+
+				if (timestamp[vertex] == 0)
+					referenced++;
+
+				if (time - timestamp[vertex] > cacheSize) //FIFO cache miss
+				{
+					timestamp[vertex] = time++;
+
+					misses++;
+				}
+			}
+
+			if (size > 2)
+				triangles += size - 2;
+
+			index += size;
+		}
+
+		if (triangles)
+			statistics.acmr = static_cast<double>(misses) / static_cast<double>(triangles);
+
+		if (referenced)
+			statistics.atvr = static_cast<double>(misses) / static_cast<double>(referenced);
+
+		return statistics;
+	}
+
+	inline float vertexScore(const int position, const int valence, const size_t cacheSize)
+	{
+		if (valence == 0) return -1.0f;
+
+		float score(0.0f);
+
+		if (position >= 0)
+		{
+			if (position < 3)
+				score = 0.75f; //The last triangle is equally cheap whatever its order
+			else
+				score = std::pow(1.0f - static_cast<float>(position - 3) / static_cast<float>(cacheSize - 3), 1.5f);
+		}
+
+		return score + 2.0f / std::sqrt(static_cast<float>(valence));
+	}
+
+	// Forsyth, Linear-Speed Vertex Cache Optimisation. Indices are local to the triangle list [0, vertexCount)
+	inline void optimizeTriangles(const std::vector<int>& indices, const size_t vertexCount, std::vector<size_t>& order, const size_t cacheSize = 32)
+	{
+		const size_t triangles = indices.size() / 3;
+
+		order.clear();
+		order.reserve(triangles);
+
+		std::vector<int>    valence(vertexCount, 0);
+		std::vector<size_t> start(vertexCount + 1, 0);
+
+		for (const auto& index : indices)
+			valence[index]++;
+
+		for (size_t vertex = 0; vertex < vertexCount; vertex++)
+			start[vertex + 1] = start[vertex] + valence[vertex];
+
+		std::vector<size_t> adjacency(indices.size());
+		std::vector<size_t> cursor(start.begin(), start.end() - 1);
+
+		for (size_t triangle = 0; triangle < triangles; triangle++)
+		{
+			adjacency[cursor[indices[triangle * 3 + 0]]++] = triangle;
+			adjacency[cursor[indices[triangle * 3 + 1]]++] = triangle;
+			adjacency[cursor[indices[triangle * 3 + 2]]++] = triangle;
+		}
+
+		std::vector<int>   position(vertexCount, -1);
+		std::vector<float> score(vertexCount);
+		std::vector<float> triangleScore(triangles);
+		std::vector<bool>  emitted(triangles, false);
+
+		for (size_t vertex = 0; vertex < vertexCount; vertex++)
+			score[vertex] = vertexScore(-1, valence[vertex], cacheSize);
+
+		for (size_t triangle = 0; triangle < triangles; triangle++)
+			triangleScore[triangle] = score[indices[triangle * 3 + 0]] + score[indices[triangle * 3 + 1]] + score[indices[triangle * 3 + 2]];
+
+		std::vector<int> cache, next;
+
+		size_t first(0);
+
+		long long best(-1);
+
+		while (order.size() < triangles)
+		{
+			if (best < 0)
+			{
+				while (emitted[first]) first++;
+
+				best = static_cast<long long>(first);
+			}
+
+			const auto triangle = static_cast<size_t>(best);
+
+			order.emplace_back(triangle);
+
+			emitted[triangle] = true;
+
+			next.clear();
+
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				const auto vertex = indices[triangle * 3 + corner];
+
+				const auto begin = adjacency.begin() + start[vertex];
+				const auto end = begin + valence[vertex];
+
+				std::iter_swap(std::find(begin, end, triangle), end - 1);
+
+				valence[vertex]--;
+
+				if (std::find(next.begin(), next.end(), vertex) == next.end())
+					next.emplace_back(vertex);
+			}
+
+			for (const auto& vertex : cache)
+			{
+				if (std::find(next.begin(), next.end(), vertex) == next.end())
+					next.emplace_back(vertex);
+			}
+
+			for (size_t index = 0; index < next.size(); index++)
+			{
+				const auto vertex = next[index];
+
+				position[vertex] = index < cacheSize ? static_cast<int>(index) : -1;
+
+				score[vertex] = vertexScore(position[vertex], valence[vertex], cacheSize);
+			}
+
+			best = -1;
+
+			float bestScore(-1.0f);
+
+			for (const auto& vertex : next)
+			{
+				for (size_t index = start[vertex]; index < start[vertex] + valence[vertex]; index++)
+				{
+					const auto candidate = adjacency[index];
+
+					const auto sum = score[indices[candidate * 3 + 0]] + score[indices[candidate * 3 + 1]] + score[indices[candidate * 3 + 2]];
+
+					triangleScore[candidate] = sum;
+
+					if (sum > bestScore)
+					{
+						bestScore = sum;
+
+						best = static_cast<long long>(candidate);
+					}
+				}
+			}
+
+			if (next.size() > cacheSize)
+				next.resize(cacheSize);
+
+			cache.swap(next);
+		}
+	}
+
+	inline size_t optimizeFaces(Load& loadOBJ, const size_t cacheSize = 32)
+	{
+		auto& face = loadOBJ.face;
+
+		const auto faces = face.vertex.size();
+
+		if (faces == 0) return 0;
+
+		std::vector<size_t> segment{ 0, faces };
+
+		for (const auto& item : loadOBJ.usemtl())
+			segment.emplace_back(std::get<1>(item));
+
+		for (const auto& item : loadOBJ.information())
+			segment.emplace_back(std::get<2>(item));
+
+		std::sort(segment.begin(), segment.end());
+
+		segment.erase(std::unique(segment.begin(), segment.end()), segment.end());
+
+		std::vector<size_t> order(faces);
+
+		for (size_t index = 0; index < faces; index++)
+			order[index] = index;
+
+		std::vector<size_t> offset; //Faces before a segment can have any number of corners
+
+		offsets(face.vertex, offset);
+
+		std::vector<int>    local(loadOBJ.vertex.size(), -1);
+		std::vector<int>    global;
+		std::vector<int>    indices;
+		std::vector<size_t> triangles;
+
+		size_t optimized(0);
+
+		for (size_t index = 0; index + 1 < segment.size(); index++)
+		{
+			const auto begin = segment[index];
+			const auto end = std::min(segment[index + 1], faces);
+
+			if (end <= begin + 1) continue;
+
+			const auto triangleOnly = std::all_of(face.vertex.s.begin() + begin, face.vertex.s.begin() + end, [](const int size) { return size == 3; });
+
+			if (!triangleOnly) continue;
+
+			const auto first = face.vertex.v.begin() + offset[begin];
+			const auto last = face.vertex.v.begin() + offset[end];
+
+			const auto valid = std::all_of(first, last, [&](const int vertex) { return vertex >= 0 && static_cast<size_t>(vertex) < local.size(); });
+
+			if (!valid) continue;
+
+			global.clear();
+			indices.clear();
+
+			for (auto vertex = first; vertex != last; ++vertex)
+			{
+				if (local[*vertex] < 0)
+				{
+					local[*vertex] = static_cast<int>(global.size());
+
+					global.emplace_back(*vertex);
+				}
+
+				indices.emplace_back(local[*vertex]);
+			}
+
+			optimizeTriangles(indices, global.size(), triangles, cacheSize);
+
+			for (size_t triangle = 0; triangle < triangles.size(); triangle++)
+				order[begin + triangle] = begin + triangles[triangle];
+
+			for (const auto& vertex : global)
+				local[vertex] = -1;
+
+			optimized += end - begin;
+		}
+
+		if (optimized == 0) return 0;
+
+		reorder(face.vertex, order);
+		reorder(face.texture, order);
+		reorder(face.normal, order);
+
+		return optimized;
+	}
+
+	template <typename T>
+	void optimizeFetch(List<T>& list, std::vector<List<int>*> indices)
+	{
+		const auto count = list.size();
+
+		if (count == 0) return;
+
+		std::vector<int> remapping(count, -1);
+
+		int next(0);
+
+		for (const auto& item : indices)
+		{
+			for (const auto& index : item->v)
+			{
+				if (index >= 0 && static_cast<size_t>(index) < count && remapping[index] < 0)
+					remapping[index] = next++;
+			}
+		}
+
+		for (auto& index : remapping)
+		{
+			if (index < 0) index = next++; //Unreferenced items are kept at the end
+		}
+
+		std::vector<size_t> order(count);
+
+		for (size_t index = 0; index < count; index++)
+			order[remapping[index]] = index;
+
+		reorder(list, order);
+
+		for (auto& item : indices)
+			remap(*item, remapping);
+	}
+
+	inline size_t optimizeFetch(Load& loadOBJ)
+	{
+		optimizeFetch(loadOBJ.vertex, { &loadOBJ.face.vertex, &loadOBJ.line.vertex, &loadOBJ.point.vertex });
+		optimizeFetch(loadOBJ.texture, { &loadOBJ.face.texture, &loadOBJ.line.texture });
+		optimizeFetch(loadOBJ.normal, { &loadOBJ.face.normal });
+
+		return loadOBJ.vertex.size();
+	}
+
+	template <typename T>
+	size_t removeUnreferenced(List<T>& list, std::vector<List<int>*> indices)
+	{
+		const auto count = list.size();
+
+		std::vector<int> remapping(count, -1);
+
+		for (const auto& item : indices)
+		{
+			for (const auto& index : item->v)
+			{
+				if (index >= 0 && static_cast<size_t>(index) < count)
+					remapping[index] = 0;
+			}
+		}
+
+		std::vector<size_t> order;
+
+		for (size_t index = 0; index < count; index++)
+		{
+			if (remapping[index] < 0) continue;
+
+			remapping[index] = static_cast<int>(order.size());
+
+			order.emplace_back(index);
+		}
+
+		if (order.size() == count) return count;
+
+		reorder(list, order);
+
+		for (auto& item : indices)
+			remap(*item, remapping);
+
+		return order.size();
+	}
+
+	// Removes vertex, texture and normal items not referenced by any face, line or point
+	inline size_t removeUnreferenced(Load& loadOBJ)
+	{
+		removeUnreferenced(loadOBJ.texture, { &loadOBJ.face.texture, &loadOBJ.line.texture });
+		removeUnreferenced(loadOBJ.normal, { &loadOBJ.face.normal });
+
+		return removeUnreferenced(loadOBJ.vertex, { &loadOBJ.face.vertex, &loadOBJ.line.vertex, &loadOBJ.point.vertex });
+	}
+
+	inline size_t optimizeVertexCache(Load& loadOBJ, CacheStatistics& before, CacheStatistics& after, const size_t cacheSize = 16)
+	{
+		before = cacheStatistics(loadOBJ.face, loadOBJ.vertex.size(), cacheSize);
+
+		const auto optimized = optimizeFaces(loadOBJ, cacheSize);
+
+		optimizeFetch(loadOBJ);
+
+		after = cacheStatistics(loadOBJ.face, loadOBJ.vertex.size(), cacheSize);
+
+		return optimized;
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+	// Additional functions for running post-load stages on all hardware threads
+	//-------------------------------------------------------------------------------------------------------
+
+	template <typename Function>
+	void parallel(const size_t count, const size_t grain, Function function)
+	{
+		if (count == 0) return;
+
+		const size_t hardware = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+		const size_t threads = std::min<size_t>(hardware, (count + grain - 1) / std::max<size_t>(1, grain));
+
+		if (threads <= 1)
+		{
+			function(static_cast<size_t>(0), count);
+
+			return;
+		}
+
+		std::vector<std::thread> worker;
+
+		const size_t step = (count + threads - 1) / threads;
+
+		for (size_t begin = 0; begin < count; begin += step)
+			worker.emplace_back(function, begin, std::min(begin + step, count));
+
+		for (auto& thread : worker)
+			thread.join();
+	}
+
+	// Returns the first count components of every item, missing components are 0, avoiding a copy when all items have count components
+	inline const float* components(const List<float>& list, const int count, std::vector<float>& scratch)
+	{
+		if (std::all_of(list.s.begin(), list.s.end(), [count](const int size) { return size == count; }))
+			return list.v.data();
+
+		scratch.resize(list.size() * count);
+
+		auto item = list.v.begin();
+
+		for (size_t index = 0; index < list.size(); index++)
+		{
+			const auto size = list.s[index];
+
+			for (int component = 0; component < count; component++)
+				scratch[index * count + component] = size > component ? *(item + component) : 0.0f;
+
+			item += size;
+		}
+
+		return scratch.data();
+	}
+
+	// Returns x, y, z for every geometric vertex
+	inline const float* vertexPositions(const Vertex& vertex, std::vector<float>& xyz)
+	{
+		return components(vertex, 3, xyz);
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+	// Additional functions for welding vertex/texture/normal corners into unique vertices
+	//-------------------------------------------------------------------------------------------------------
+
+	struct Weld
+	{
+		void clear();
+
+		std::vector<int> vertex;  //Geometric vertex index per welded vertex
+		std::vector<int> texture; //Texture vertex index per welded vertex, -1 if none
+		std::vector<int> normal;  //Normal vertex index per welded vertex, -1 if none
+		std::vector<int> index;   //Welded vertex index per face corner, parallel to face.vertex.v
+	};
+
+	inline void Weld::clear()
+	{
+		vertex.clear();
+		texture.clear();
+		normal.clear();
+		index.clear();
+	}
+
+	struct WeldKey
+	{
+		bool operator==(const WeldKey& other) const
+		{
+			return vertex == other.vertex && texture == other.texture && normal == other.normal;
+		}
+
+		int vertex;
+		int texture;
+		int normal;
+	};
+
+	struct WeldHash
+	{
+		size_t operator()(const WeldKey& key) const
+		{
+			size_t hash = static_cast<size_t>(static_cast<unsigned int>(key.vertex)) * 73856093u;
+
+			hash ^= static_cast<size_t>(static_cast<unsigned int>(key.texture)) * 19349663u;
+			hash ^= static_cast<size_t>(static_cast<unsigned int>(key.normal)) * 83492791u;
+
+			return hash;
+		}
+	};
+
+	inline size_t weld(const Face& face, Weld& weld)
+	{
+		weld.clear();
+
+		const auto corners = face.vertex.v.size();
+
+		if (corners == 0) return 0;
+
+		weld.index.resize(corners);
+
+		std::unordered_map<WeldKey, int, WeldHash> unique;
+
+		unique.reserve(corners);
+
+		size_t vertex(0), texture(0), normal(0);
+
+		for (size_t item = 0; item < face.vertex.size(); item++)
+		{
+			const auto size = static_cast<size_t>(face.vertex.s[item]);
+
+			const auto hasTexture = item < face.texture.size() && static_cast<size_t>(face.texture.s[item]) == size;
+			const auto hasNormal = item < face.normal.size() && static_cast<size_t>(face.normal.s[item]) == size;
+
+			for (size_t corner = 0; corner < size; corner++)
+			{
+				const WeldKey key
+				{
+					face.vertex.v[vertex + corner],
+					hasTexture ? face.texture.v[texture + corner] : -1,
+					hasNormal ? face.normal.v[normal + corner] : -1
+				};
+
+				const auto find = unique.emplace(key, static_cast<int>(weld.vertex.size()));
+
+				if (find.second)
+				{
+					weld.vertex.emplace_back(key.vertex);
+					weld.texture.emplace_back(key.texture);
+					weld.normal.emplace_back(key.normal);
+				}
+
+				weld.index[vertex + corner] = find.first->second;
+			}
+
+			vertex += size;
+
+			if (item < face.texture.size()) texture += face.texture.s[item];
+			if (item < face.normal.size()) normal += face.normal.s[item];
+		}
+
+		return weld.vertex.size();
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+	// Additional functions for splitting faces into meshlets (clusters) for mesh shader renderers
+	//-------------------------------------------------------------------------------------------------------
+
+	struct Meshlet
+	{
+		size_t vertexOffset;   //First item in Meshlets::vertex
+		size_t triangleOffset; //First item in Meshlets::triangle, three local indices per triangle
+		size_t vertexCount;
+		size_t triangleCount;
+
+		float center[3];       //Bounding sphere
+		float radius;
+
+		float axis[3];         //Normal cone, backfacing if dot(normalize(center - eye), axis) >= cutoff
+		float cutoff;          //1 if the cone is too wide to cull
+	};
+
+	struct Meshlets
+	{
+		void clear();
+
+		std::vector<Meshlet>       meshlet;
+		std::vector<int>           vertex;   //Welded vertex index per meshlet vertex, see weld
+		std::vector<unsigned char> triangle; //Meshlet local vertex indices
+		Weld                       weld;
+	};
+
+	inline void Meshlets::clear()
+	{
+		meshlet.clear();
+		vertex.clear();
+		triangle.clear();
+		weld.clear();
+	}
+
+	inline void meshletBounds(const Meshlets& meshlets, Meshlet& meshlet, const float* xyz)
+	{
+		float minimum[3] = { 0.0f, 0.0f, 0.0f };
+		float maximum[3] = { 0.0f, 0.0f, 0.0f };
+
+		for (size_t index = 0; index < meshlet.vertexCount; index++)
+		{
+			const float* p = xyz + meshlets.weld.vertex[meshlets.vertex[meshlet.vertexOffset + index]] * 3;
+
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				minimum[axis] = index == 0 ? p[axis] : std::min(minimum[axis], p[axis]);
+				maximum[axis] = index == 0 ? p[axis] : std::max(maximum[axis], p[axis]);
+			}
+		}
+
+		float radius(0.0f);
+
+		for (size_t axis = 0; axis < 3; axis++)
+			meshlet.center[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+
+		for (size_t index = 0; index < meshlet.vertexCount; index++)
+		{
+			const float* p = xyz + meshlets.weld.vertex[meshlets.vertex[meshlet.vertexOffset + index]] * 3;
+
+			const float dx = p[0] - meshlet.center[0];
+			const float dy = p[1] - meshlet.center[1];
+			const float dz = p[2] - meshlet.center[2];
+
+			radius = std::max(radius, dx * dx + dy * dy + dz * dz);
+		}
+
+		meshlet.radius = std::sqrt(radius);
+
+		std::vector<float> normal;
+
+		normal.reserve(meshlet.triangleCount * 3);
+
+		float sum[3] = { 0.0f, 0.0f, 0.0f };
+
+		for (size_t triangle = 0; triangle < meshlet.triangleCount; triangle++)
+		{
+			const float* p[3];
+
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				const auto local = meshlets.triangle[meshlet.triangleOffset + triangle * 3 + corner];
+
+				p[corner] = xyz + meshlets.weld.vertex[meshlets.vertex[meshlet.vertexOffset + local]] * 3;
+			}
+
+			const float u[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+			const float v[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+
+			float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+
+			const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			if (length == 0.0f) continue; //Degenerate triangle
+
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				n[axis] /= length;
+
+				sum[axis] += n[axis];
+
+				normal.emplace_back(n[axis]);
+			}
+		}
+
+		const float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+
+		meshlet.axis[0] = meshlet.axis[1] = meshlet.axis[2] = 0.0f;
+
+		meshlet.cutoff = 1.0f;
+
+		if (length == 0.0f || normal.empty()) return;
+
+		for (size_t axis = 0; axis < 3; axis++)
+			meshlet.axis[axis] = sum[axis] / length;
+
+		float minimumDot(1.0f);
+
+		for (size_t index = 0; index < normal.size(); index += 3)
+			minimumDot = std::min(minimumDot, normal[index + 0] * meshlet.axis[0] + normal[index + 1] * meshlet.axis[1] + normal[index + 2] * meshlet.axis[2]);
+
+		if (minimumDot > 0.1f)
+			meshlet.cutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+	}
+
+	// Greedy clustering of triangles [0, count) in 'corners', prefers triangles adding fewest new vertices and closest to the meshlet center
+	inline void buildMeshlets(const int* corners, const size_t count, const float* xyz, const Weld& weld, const size_t maxVertices, const size_t maxTriangles, Meshlets& meshlets)
+	{
+		std::unordered_map<int, int> compact;
+
+		std::vector<int> local(count * 3);
+		std::vector<int> welded;
+
+		for (size_t index = 0; index < count * 3; index++)
+		{
+			const auto find = compact.emplace(corners[index], static_cast<int>(welded.size()));
+
+			if (find.second)
+				welded.emplace_back(corners[index]);
+
+			local[index] = find.first->second;
+		}
+
+		const auto vertexCount = compact.size();
+
+		std::vector<size_t> start(vertexCount + 1, 0);
+
+		for (const auto& vertex : local)
+			start[vertex + 1]++;
+
+		for (size_t vertex = 0; vertex < vertexCount; vertex++)
+			start[vertex + 1] += start[vertex];
+
+		std::vector<size_t> adjacency(local.size());
+		std::vector<size_t> cursor(start.begin(), start.end() - 1);
+
+		for (size_t index = 0; index < local.size(); index++)
+			adjacency[cursor[local[index]]++] = index / 3;
+
+		std::vector<bool>  used(count, false);
+		std::vector<int>   slot(vertexCount, -1);
+		std::vector<float> centroid(count * 3);
+
+		for (size_t triangle = 0; triangle < count; triangle++)
+		{
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				centroid[triangle * 3 + axis] = (xyz[weld.vertex[corners[triangle * 3 + 0]] * 3 + axis] +
+				                                 xyz[weld.vertex[corners[triangle * 3 + 1]] * 3 + axis] +
+				                                 xyz[weld.vertex[corners[triangle * 3 + 2]] * 3 + axis]) / 3.0f;
+			}
 		}
 
-		item.insert(texture);
+		std::vector<int> vertices; //Chunk local vertex per meshlet vertex
+
+		Meshlet meshlet{};
+
+		float center[3] = { 0.0f, 0.0f, 0.0f };
+
+		size_t first(0), emitted(0);
+
+		auto finish = [&]()
+		{
+			if (meshlet.triangleCount == 0) return;
+
+			for (const auto& vertex : vertices)
+			{
+				meshlets.vertex.emplace_back(welded[vertex]);
+
+				slot[vertex] = -1;
+			}
+
+			meshlet.vertexCount = vertices.size();
+
+			meshlets.meshlet.emplace_back(meshlet);
+
+			vertices.clear();
+
+			meshlet = Meshlet{};
+
+			meshlet.vertexOffset = meshlets.vertex.size();
+			meshlet.triangleOffset = meshlets.triangle.size();
+
+			center[0] = center[1] = center[2] = 0.0f;
+		};
+
+		meshlet.vertexOffset = meshlets.vertex.size();
+		meshlet.triangleOffset = meshlets.triangle.size();
+
+		while (emitted < count)
+		{
+			long long best(-1);
+
+			size_t bestNew(4);
+
+			float bestDistance(0.0f);
+
+			for (const auto& vertex : vertices)
+			{
+				for (size_t index = start[vertex]; index < start[vertex + 1]; index++)
+				{
+					const auto triangle = adjacency[index];
+
+					if (used[triangle]) continue;
+
+					size_t extra(0);
+
+					for (size_t corner = 0; corner < 3; corner++)
+						extra += slot[local[triangle * 3 + corner]] < 0 ? 1 : 0;
+
+					const float dx = centroid[triangle * 3 + 0] - center[0];
+					const float dy = centroid[triangle * 3 + 1] - center[1];
+					const float dz = centroid[triangle * 3 + 2] - center[2];
+
+					const float distance = dx * dx + dy * dy + dz * dz;
+
+					if (extra < bestNew || (extra == bestNew && distance < bestDistance))
+					{
+						best = static_cast<long long>(triangle);
+
+						bestNew = extra;
+
+						bestDistance = distance;
+					}
+				}
+			}
+
+			if (best < 0)
+			{
+				while (used[first]) first++;
+
+				best = static_cast<long long>(first);
+
+				bestNew = 0;
+
+				for (size_t corner = 0; corner < 3; corner++)
+					bestNew += slot[local[first * 3 + corner]] < 0 ? 1 : 0;
+			}
+
+			if (vertices.size() + bestNew > maxVertices || meshlet.triangleCount + 1 > maxTriangles)
+			{
+				finish();
+
+				continue;
+			}
+
+			const auto triangle = static_cast<size_t>(best);
+
+			used[triangle] = true;
+
+			emitted++;
+
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				const auto vertex = local[triangle * 3 + corner];
+
+				if (slot[vertex] < 0)
+				{
+					slot[vertex] = static_cast<int>(vertices.size());
+
+					vertices.emplace_back(vertex);
+				}
+
+				meshlets.triangle.emplace_back(static_cast<unsigned char>(slot[vertex]));
+			}
+
+			meshlet.triangleCount++;
+
+			const float weight = 1.0f / static_cast<float>(meshlet.triangleCount);
+
+			for (size_t axis = 0; axis < 3; axis++)
+				center[axis] += (centroid[triangle * 3 + axis] - center[axis]) * weight;
+		}
+
+		finish();
+	}
+
+	inline size_t meshlets(const Load& loadOBJ, Meshlets& meshlets, const size_t maxVertices = 64, const size_t maxTriangles = 124)
+	{
+		meshlets.clear();
+
+		if (maxVertices < 3 || maxVertices > 256 || maxTriangles == 0)
+			return 0;
+
+		if (weld(loadOBJ.face, meshlets.weld) == 0)
+			return 0;
+
+		std::vector<int> corners; //Welded vertex indices, three per triangle
+
+		size_t offset(0);
+
+		for (const auto& size : loadOBJ.face.vertex.s)
+		{
+			for (int corner = 1; corner + 1 < size; corner++) //Polygons are fan triangulated
+			{
+				corners.emplace_back(meshlets.weld.index[offset]);
+				corners.emplace_back(meshlets.weld.index[offset + corner]);
+				corners.emplace_back(meshlets.weld.index[offset + corner + 1]);
+			}
+
+			offset += size;
+		}
+
+		const auto valid = std::all_of(meshlets.weld.vertex.begin(), meshlets.weld.vertex.end(), [&](const int vertex) { return vertex >= 0 && static_cast<size_t>(vertex) < loadOBJ.vertex.size(); });
+
+		if (!valid) return 0;
+
+		std::vector<float> scratch;
+
+		const float* xyz = vertexPositions(loadOBJ.vertex, scratch);
+
+		const size_t triangles = corners.size() / 3;
+
+		const size_t chunk = 1 << 16; //Triangles per independent chunk, independent of the number of threads
+
+		const size_t chunks = (triangles + chunk - 1) / chunk;
+
+		std::vector<Meshlets> partial(chunks);
+
+		parallel(chunks, 1, [&](const size_t begin, const size_t end)
+		{
+			for (size_t index = begin; index < end; index++)
+			{
+				const size_t first = index * chunk;
+
+				const size_t count = std::min(chunk, triangles - first);
+
+				buildMeshlets(corners.data() + first * 3, count, xyz, meshlets.weld, maxVertices, maxTriangles, partial[index]);
+			}
+		});
+
+		for (auto& item : partial)
+		{
+			const auto vertexOffset = meshlets.vertex.size();
+			const auto triangleOffset = meshlets.triangle.size();
+
+			for (auto meshlet : item.meshlet)
+			{
+				meshlet.vertexOffset += vertexOffset;
+				meshlet.triangleOffset += triangleOffset;
+
+				meshlets.meshlet.emplace_back(meshlet);
+			}
+
+			meshlets.vertex.insert(meshlets.vertex.end(), item.vertex.begin(), item.vertex.end());
+			meshlets.triangle.insert(meshlets.triangle.end(), item.triangle.begin(), item.triangle.end());
+
+			item.clear();
+		}
+
+		parallel(meshlets.meshlet.size(), 1024, [&](const size_t begin, const size_t end)
+		{
+			for (size_t index = begin; index < end; index++)
+				meshletBounds(meshlets, meshlets.meshlet[index], xyz);
+		});
+
+		return meshlets.meshlet.size();
+	}
+
+	//-------------------------------------------------------------------------------------------------------
+	// Additional functions for scanning an obj file for counts, bounds and names without building geometry
+	//-------------------------------------------------------------------------------------------------------
+
+	struct Stat
+	{
+		void clear();
+
+		void merge(const Stat& other, std::unordered_set<std::string>* seen = nullptr); //seen: names in usemtl, object and group, kept by the caller over many merges
+
+		size_t bytes;
+		size_t rows;
+		size_t vertex;
+		size_t texture;
+		size_t normal;
+		size_t face;
+		size_t line;
+		size_t point;
+		size_t comment;
+
+		float minimum[3]; //Bounding box of the geometric vertices
+		float maximum[3];
+
+		std::string              mtllib;
+		std::vector<std::string> usemtl;  //Unique names in file order
+		std::vector<std::string> object;
+		std::vector<std::string> group;
+	};
+
+	inline void Stat::clear()
+	{
+		bytes = rows = vertex = texture = normal = face = line = point = comment = 0;
+
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			minimum[axis] = HUGE_VALF;
+			maximum[axis] = -HUGE_VALF;
+		}
+
+		mtllib.clear();
+		usemtl.clear();
+		object.clear();
+		group.clear();
+	}
+
+	inline void unique(std::vector<std::string>& list, const std::vector<std::string>& names, std::unordered_set<std::string>& seen)
+	{
+		for (const auto& name : names)
+		{
+			if (seen.insert(name).second)
+				list.emplace_back(name);
+		}
+	}
+
+	inline void Stat::merge(const Stat& other, std::unordered_set<std::string>* seen)
+	{
+		bytes += other.bytes;
+		rows += other.rows;
+		vertex += other.vertex;
+		texture += other.texture;
+		normal += other.normal;
+		face += other.face;
+		line += other.line;
+		point += other.point;
+		comment += other.comment;
+
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			minimum[axis] = std::min(minimum[axis], other.minimum[axis]);
+			maximum[axis] = std::max(maximum[axis], other.maximum[axis]);
+		}
+
+		if (mtllib.empty())
+			mtllib = other.mtllib;
+
+		std::unordered_set<std::string> local[3];
+
+		if (seen == nullptr) //Built from the lists for a single merge
+		{
+			local[0].insert(usemtl.begin(), usemtl.end());
+			local[1].insert(object.begin(), object.end());
+			local[2].insert(group.begin(), group.end());
+
+			seen = local;
+		}
+
+		unique(usemtl, other.usemtl, seen[0]);
+		unique(object, other.object, seen[1]);
+		unique(group, other.group, seen[2]);
+	}
+
+	inline std::string name(const char* begin, const char* end)
+	{
+		while (begin < end && isspace(*begin)) begin++;
+
+		while (end > begin && (isspace(*(end - 1)) || *(end - 1) == '\r')) end--;
+
+		return std::string(begin, end);
+	}
+
+	// Scans the rows in [begin, end), end is a row boundary followed by readable memory ('\n' or '\0')
+	inline void scan(const char* begin, const char* end, Stat& stat)
+	{
+		std::unordered_set<std::string> usemtl, object, group;
+
+		const char* line = begin;
+
+		while (line < end)
+		{
+			auto next = static_cast<const char*>(memchr(line, '\n', static_cast<size_t>(end - line)));
+
+			if (next == nullptr)
+				next = end;
+
+			while (line < next && isspace(*line)) line++;
+
+			const auto second = line + 1 < next ? *(line + 1) : '\0';
+
+			const auto third = line + 2 < next ? *(line + 2) : '\0';
+
+			switch (*line) //Keywords must be followed by whitespace, as in Load::load
+			{
+			case 'v':
+				if (second == 't' && isspace(third))
+					stat.texture++;
+				else if (second == 'n' && isspace(third))
+					stat.normal++;
+				else if (isspace(second))
+				{
+					float xyz[3] = { 0.0f, 0.0f, 0.0f };
+
+					const char* p = line + 2;
+
+					for (size_t axis = 0; axis < 3; axis++)
+					{
+						if (!strtof(p, xyz[axis], p)) break;
+
+						stat.minimum[axis] = std::min(stat.minimum[axis], xyz[axis]);
+						stat.maximum[axis] = std::max(stat.maximum[axis], xyz[axis]);
+					}
+
+					stat.vertex++;
+				}
+				break;
+
+			case 'f': if (isspace(second)) stat.face++; break;
+			case 'l': if (isspace(second)) stat.line++; break; //Not lod
+			case 'p': if (isspace(second)) stat.point++; break; //Not parm
+			case '#': stat.comment++; break;
+
+			case 'u':
+				if (keyword(line, "usemtl"))
+				{
+					auto item = name(line + 6, next);
+
+					if (usemtl.insert(item).second)
+						stat.usemtl.emplace_back(item);
+				}
+				break;
+
+			case 'm':
+				if (stat.mtllib.empty() && keyword(line, "mtllib"))
+					stat.mtllib = name(line + 6, next);
+				break;
+
+			case 'o':
+				if (isspace(second) || iseol(second))
+				{
+					auto item = name(line + 1, next);
+
+					if (object.insert(item).second)
+						stat.object.emplace_back(item);
+				}
+				break;
+
+			case 'g':
+				if (isspace(second) || iseol(second))
+				{
+					const auto names = name(line + 1, next);
+
+					size_t first(0);
+
+					while (first < names.size()) //"g name1 name2 ...", as in Hierarchy::open
+					{
+						const auto last = std::min(names.find_first_of(" \t", first), names.size());
+
+						if (last > first)
+						{
+							auto item = names.substr(first, last - first);
+
+							if (group.insert(item).second)
+								stat.group.emplace_back(item);
+						}
+
+						first = last + 1;
+					}
+				}
+				break;
+			}
+
+			stat.rows++;
+
+			line = next + 1;
+		}
+
+		stat.bytes += static_cast<size_t>(end - begin);
+	}
+
+	// Scans the buffer on all hardware threads, chunks are split at row boundaries
+	// seen holds the names already in stat (usemtl, object and group), so names are merged in linear time
+	inline void scan(const char* buffer, const size_t size, Stat& stat, std::unordered_set<std::string>* seen = nullptr)
+	{
+		const size_t grain = 1 << 20;
+
+		const size_t chunks = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), size / grain));
+
+		std::vector<const char*> boundary{ buffer };
+
+		for (size_t chunk = 1; chunk < chunks; chunk++)
+		{
+			const char* split = std::max(boundary.back(), buffer + size * chunk / chunks);
+
+			const auto next = static_cast<const char*>(memchr(split, '\n', static_cast<size_t>(buffer + size - split)));
+
+			if (next == nullptr) break;
+
+			boundary.emplace_back(next + 1);
+		}
+
+		boundary.emplace_back(buffer + size);
+
+		std::vector<Stat> partial(boundary.size() - 1);
+
+		for (auto& item : partial)
+			item.clear();
+
+		parallel(partial.size(), 1, [&](const size_t begin, const size_t end)
+		{
+			for (size_t index = begin; index < end; index++)
+				scan(boundary[index], boundary[index + 1], partial[index]);
+		});
+
+		for (const auto& item : partial)
+			stat.merge(item, seen);
+	}
+
+	// Counts rows, computes the bounding box and collects names, the file is read in large blocks
+	// Progress is reported and cancel checked once per block
+	inline bool stat(const std::string& path, Stat& stat, const std::function<void(const Progress&)>& progress = nullptr, const std::atomic<bool>* cancel = nullptr)
+	{
+		stat.clear();
+
+		FILE* file = fopen(path.c_str(), "rb");
+
+		if (file == nullptr)
+			return false;
+
+		struct stat info {};
+		::stat(path.c_str(), &info);
+
+		const auto start = std::chrono::steady_clock::now();
+
+		Progress state{ 0, static_cast<size_t>(info.st_size), 0, 0.0, 0.0 };
+
+		const size_t block = 64 << 20;
+
+		std::vector<char> buffer(block + 1);
+
+		size_t size(0); //Bytes in buffer, the unscanned rest of the previous block first
+
+		std::unordered_set<std::string> seen[3]; //usemtl, object and group names found so far
+
+		while (true)
+		{
+			const auto capacity = buffer.size() - 1;
+
+			size += fread(buffer.data() + size, sizeof(char), capacity - size, file);
+
+			const auto end = size < capacity;
+
+			auto scanned = size;
+
+			if (!end)
+			{
+				while (scanned > 0 && buffer[scanned - 1] != '\n') scanned--;
+
+				if (scanned == 0) //Row longer than the buffer
+				{
+					buffer.resize(buffer.size() + block);
+
+					continue;
+				}
+			}
+
+			const auto keep = buffer[scanned];
+
+			buffer[scanned] = '\0';
+
+			if (scanned)
+				scan(buffer.data(), scanned, stat, seen);
+
+			state.bytes += scanned;
+
+			if (progress)
+			{
+				state.elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+				state.remaining = state.bytes ? state.elapsed * static_cast<double>(state.total - std::min(state.bytes, state.total)) / static_cast<double>(state.bytes) : 0.0;
+
+				progress(state);
+			}
+
+			if (cancel && cancel->load(std::memory_order_relaxed))
+			{
+				fclose(file);
+
+				return false;
+			}
+
+			if (end) break;
+
+			buffer[scanned] = keep;
+
+			std::copy(buffer.begin() + scanned, buffer.begin() + size, buffer.begin());
+
+			size -= scanned;
+		}
+
+		fclose(file);
+
+		if (stat.vertex == 0)
+		{
+			for (size_t axis = 0; axis < 3; axis++)
+				stat.minimum[axis] = stat.maximum[axis] = 0.0f;
+		}
 
 		return true;
 	}
 
-	inline bool iseol(const char& c)
-	{
-		return c == '\r' || c == '\n' || c == '\0';
-	}
+	//-------------------------------------------------------------------------------------------------------
+	// Additional functions for generating normals when the file has no vn lines
+	//-------------------------------------------------------------------------------------------------------
 
-	inline bool parse(const char* line, Point& item, const size_t pointSize)
+	enum NormalWeight
 	{
-		static int i, v;
+		areaWeight,
+		angleWeight
+	};
 
-		static std::vector<int> vertex;
+	// Normal (not normalized, length is twice the area) of a polygon, Newell's method
+	inline void faceNormal(const float* xyz, const int* index, const int size, float* normal)
+	{
+		normal[0] = normal[1] = normal[2] = 0.0f;
 
-		vertex.clear();
+		for (int corner = 0; corner < size; corner++)
+		{
+			const float* a = xyz + index[corner] * 3;
+			const float* b = xyz + index[(corner + 1) % size] * 3;
 
-		v = static_cast<int>(pointSize);
+			normal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+			normal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+			normal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+		}
+	}
 
-		while (!iseol(*line))
-		{
-			if (!strtoi(line, i, line))
-				return false;
+	// Angle between the edges to the previous and the next corner of a polygon
+	inline float cornerAngle(const float* xyz, const int* index, const int size, const int corner)
+	{
+		const float* p = xyz + index[corner] * 3;
+		const float* a = xyz + index[(corner + size - 1) % size] * 3;
+		const float* b = xyz + index[(corner + 1) % size] * 3;
 
-			i = i > 0 ? i - 1 : i + v;
+		const float u[3] = { a[0] - p[0], a[1] - p[1], a[2] - p[2] };
+		const float v[3] = { b[0] - p[0], b[1] - p[1], b[2] - p[2] };
 
-			vertex.push_back(i);
+		const float length = std::sqrt((u[0] * u[0] + u[1] * u[1] + u[2] * u[2]) * (v[0] * v[0] + v[1] * v[1] + v[2] * v[2]));
 
-			while (isspace(*line))
-				line++;
-		}
+		if (length == 0.0f) return 0.0f;
 
-		item.vertex.insert(vertex);
+		const float cosine = (u[0] * v[0] + u[1] * v[1] + u[2] * v[2]) / length;
 
-		return true;
+		return std::acos(std::max(-1.0f, std::min(1.0f, cosine)));
 	}
 
-	inline bool parse(const char* line, Line& item, const size_t pointSize)
+	// Smoothing group id per face, every face is smooth if the file has no s lines
+	inline void faceSmoothing(Load& loadOBJ, std::vector<int>& smoothing)
 	{
-		static int i, v;
+		const auto& information = loadOBJ.information();
 
-		static std::vector<int> vertex;
-		static std::vector<int> texture;
+		const auto found = std::any_of(information.begin(), information.end(), [](const std::tuple<char, std::string, size_t>& item) { return std::get<0>(item) == 's'; });
 
-		vertex.clear();
-		texture.clear();
+		smoothing.assign(loadOBJ.face.vertex.size(), found ? 0 : 1);
 
-		v = static_cast<int>(pointSize);
+		if (!found) return;
 
-		while (!iseol(*line))
+		for (const auto& item : loadOBJ.hierarchy.smoothing)
 		{
-			if (!strtoi(line, i, line))
-				return false;
+			const auto end = std::min(item.face.end, smoothing.size());
 
-			i = i > 0 ? i - 1 : i + v;
+			for (size_t face = item.face.begin; face < end; face++)
+				smoothing[face] = item.id;
+		}
+	}
 
-			vertex.push_back(i);
+	// Computes face normals and vertex normals weighted by area or angle, vertices are shared within a smoothing
+	// group, faces with smoothing off get their face normal. Replaces normal and face.normal.
+	inline size_t generateNormals(Load& loadOBJ, const NormalWeight weight = angleWeight, const bool force = false)
+	{
+		auto& face = loadOBJ.face;
 
-			if (*line == '/')
-			{
-				line++;
+		if (!force && !loadOBJ.normal.empty())
+			return 0;
 
-				if (!strtoi(line, i, line))
-					return false;
+		if (face.vertex.empty() || loadOBJ.vertex.empty())
+			return 0;
 
-				i = i > 0 ? i - 1 : i + v;
+		const auto& index = face.vertex.v;
 
-				texture.push_back(i);
-			}
+		const auto valid = std::all_of(index.begin(), index.end(), [&](const int vertex) { return vertex >= 0 && static_cast<size_t>(vertex) < loadOBJ.vertex.size(); });
 
-			while (isspace(*line))
-				line++;
-		}
+		if (!valid) return 0;
 
-		item.vertex.insert(vertex);
-		item.texture.insert(texture);
+		std::vector<float> scratch;
 
-		return true;
-	}
+		const float* xyz = vertexPositions(loadOBJ.vertex, scratch);
 
-	inline bool parse(const char* line, Face& item, const size_t pointSize, bool triangulate)
-	{
-		static int i, v;
+		const auto faces = face.vertex.size();
 
-		static std::vector<int> vertex;
-		static std::vector<int> texture;
-		static std::vector<int> normal;
+		std::vector<size_t> offset;
 
-		vertex.clear();
-		texture.clear();
-		normal.clear();
+		offsets(face.vertex, offset);
 
-		v = static_cast<int>(pointSize);
+		std::vector<int> smoothing;
 
-		while (!iseol(*line))
-		{
-			if (!strtoi(line, i, line))
-				return false;
+		faceSmoothing(loadOBJ, smoothing);
 
-			i = i > 0 ? i - 1 : i + v;
+		std::vector<int> cornerNormal(index.size());
+		std::vector<int> cornerFace(index.size());
 
-			vertex.emplace_back(i);
+		std::unordered_map<unsigned long long, int> shared;
 
-			if (*line == '/')
+		int normals(0);
+
+		for (size_t item = 0; item < faces; item++)
+		{
+			int flat(-1);
+
+			for (size_t corner = offset[item]; corner < offset[item + 1]; corner++)
 			{
-				line++;
+				cornerFace[corner] = static_cast<int>(item);
 
-				if (*line != '/')
+				if (smoothing[item] == 0)
 				{
-					if (!strtoi(line, i, line))
-						return false;
+					if (flat < 0) flat = normals++;
 
-					i = i > 0 ? i - 1 : i + v;
+					cornerNormal[corner] = flat;
 
-					texture.emplace_back(i);
+					continue;
 				}
 
-				if (*line == '/')
-				{
-					line++;
+				const auto key = (static_cast<unsigned long long>(static_cast<unsigned int>(index[corner])) << 32) | static_cast<unsigned int>(smoothing[item]);
 
-					if (!strtoi(line, i, line))
-						return false;
+				const auto find = shared.emplace(key, normals);
 
-					i = i > 0 ? i - 1 : i + v;
+				if (find.second) normals++;
 
-					normal.emplace_back(i);
-				}
+				cornerNormal[corner] = find.first->second;
 			}
-
-			while (isspace(*line))
-				line++;
 		}
 
-		insert_indices(item.vertex, vertex, triangulate);
-		insert_indices(item.texture, texture, triangulate);
-		insert_indices(item.normal, normal, triangulate);
+		std::vector<float> normalOfFace(faces * 3);
 
-		return true;
-	}
+		parallel(faces, 4096, [&](const size_t begin, const size_t end)
+		{
+			for (size_t item = begin; item < end; item++)
+				faceNormal(xyz, &index[offset[item]], face.vertex.s[item], &normalOfFace[item * 3]);
+		});
 
-	inline void insert_indices(List<int>& list, const std::vector<int>& indices, bool triangulate)
-	{
-		if (triangulate && indices.size() > 3)
-			triangulate_indices(list, indices);
-		else
-			list.insert(indices);
-	}
+		std::vector<size_t> start(normals + 1, 0);
 
-	inline void triangulate_indices(List<int>& list, const std::vector<int>& indices)
-	{
-		static size_t size, index;
+		for (const auto& normal : cornerNormal)
+			start[normal + 1]++;
 
-		size = indices.size();
+		for (int normal = 0; normal < normals; normal++)
+			start[normal + 1] += start[normal];
 
-		static std::vector<int> triangle;
+		std::vector<size_t> corners(index.size());
+		std::vector<size_t> cursor(start.begin(), start.end() - 1);
 
-		for (index = 0; index < size - 2; index++)
+		for (size_t corner = 0; corner < index.size(); corner++)
+			corners[cursor[cornerNormal[corner]]++] = corner;
+
+		std::vector<float> result(static_cast<size_t>(normals) * 3);
+
+		parallel(static_cast<size_t>(normals), 4096, [&](const size_t begin, const size_t end)
 		{
-			triangle.clear();
+			for (size_t normal = begin; normal < end; normal++)
+			{
+				float sum[3] = { 0.0f, 0.0f, 0.0f };
 
-			triangle.push_back(indices[index + 1]);
-			triangle.push_back(indices[index + 2]);
-			triangle.push_back(indices[0]);
+				for (size_t item = start[normal]; item < start[normal + 1]; item++)
+				{
+					const auto corner = corners[item];
+					const auto owner = static_cast<size_t>(cornerFace[corner]);
 
-			list.insert(triangle);
-		}
-	}
+					const float* n = &normalOfFace[owner * 3];
 
-	// <-------- End of WavefrontOBJ.h 
+					float scale(1.0f);
+
+					if (weight == angleWeight)
+					{
+						const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+						const auto size = face.vertex.s[owner];
+
+						scale = length > 0.0f ? cornerAngle(xyz, &index[offset[owner]], size, static_cast<int>(corner - offset[owner])) / length : 0.0f;
+					}
+
+					sum[0] += n[0] * scale;
+					sum[1] += n[1] * scale;
+					sum[2] += n[2] * scale;
+				}
+
+				const float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+
+				const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+
+				result[normal * 3 + 0] = sum[0] * scale;
+				result[normal * 3 + 1] = sum[1] * scale;
+				result[normal * 3 + 2] = sum[2] * scale;
+			}
+		});
+
+		loadOBJ.normal.v.swap(result);
+		loadOBJ.normal.s.assign(static_cast<size_t>(normals), 3);
+
+		face.normal.v.swap(cornerNormal);
+		face.normal.s = face.vertex.s;
+
+		return static_cast<size_t>(normals);
+	}
 
 	//-------------------------------------------------------------------------------------------------------
-	// Additional functions to simplify the connection between each face and material/color (Kd)
+	// Additional functions for generating tangents for normal mapping
 	//-------------------------------------------------------------------------------------------------------
 
-	template <typename LoadMTL>
-	size_t connectFaceMaterial(Load& loadOBJ, LoadMTL& loadMTL, std::vector<int>& connect)
+	inline void normalize(float* xyz)
 	{
-		size_t lastFace;
+		const float length = std::sqrt(xyz[0] * xyz[0] + xyz[1] * xyz[1] + xyz[2] * xyz[2]);
 
-		connect.clear();
+		if (length == 0.0f) return;
 
-		auto& materials = loadMTL.materials();
+		xyz[0] /= length;
+		xyz[1] /= length;
+		xyz[2] /= length;
+	}
 
-		if (materials.size() == 0) return 0;
+	// Tangent x, y, z and handedness w (bitangent = w * cross(normal, tangent)) per welded vertex, see weld.
+	// Follows MikkTSpace: normalized per triangle tangents weighted by corner angle, orthogonalized to the normal.
+	inline size_t generateTangents(const Load& loadOBJ, Weld& weld, std::vector<float>& tangent)
+	{
+		tangent.clear();
 
-		if (loadOBJ.face.vertex.empty()) return 0;
+		if (obj::weld(loadOBJ.face, weld) == 0)
+			return 0;
 
-		std::map<std::string, int> materialNameIndex;
+		const auto vertices = weld.vertex.size();
 
-		for (size_t index = 0; index < materials.size(); index++)
+		for (size_t item = 0; item < vertices; item++)
 		{
-			std::string material = materials[index].name;
-
-			materialNameIndex[material] = static_cast<int>(index);
+			if (weld.vertex[item] < 0 || static_cast<size_t>(weld.vertex[item]) >= loadOBJ.vertex.size()) return 0;
+			if (weld.texture[item] >= 0 && static_cast<size_t>(weld.texture[item]) >= loadOBJ.texture.size()) return 0;
+			if (weld.normal[item] >= 0 && static_cast<size_t>(weld.normal[item]) >= loadOBJ.normal.size()) return 0;
 		}
 
-		const auto& materialFace = loadOBJ.usemtl();
+		std::vector<float> scratchVertex, scratchTexture, scratchNormal;
 
-		for (size_t index = 0; index < materialFace.size(); index++)
-		{
-			const auto& item = materialFace[index];
+		const float* xyz = components(loadOBJ.vertex, 3, scratchVertex);
+		const float* uv = components(loadOBJ.texture, 2, scratchTexture);
+		const float* normal = components(loadOBJ.normal, 3, scratchNormal);
 
-			const auto& material = std::get<0>(item);
-			const auto& fromFace = std::get<1>(item);
+		std::vector<int> corners; //Welded vertex indices, three per triangle
 
-			if (index == materialFace.size() - 1)
-				lastFace = loadOBJ.face.vertex.size();
-			else
-			{
-				const auto& next = materialFace[index + 1];
+		size_t offset(0);
 
-				lastFace = std::get<1>(next);
+		for (const auto& size : loadOBJ.face.vertex.s)
+		{
+			for (int corner = 1; corner + 1 < size; corner++) //Polygons are fan triangulated
+			{
+				corners.emplace_back(weld.index[offset]);
+				corners.emplace_back(weld.index[offset + corner]);
+				corners.emplace_back(weld.index[offset + corner + 1]);
 			}
 
-			int materialIndex(-1);
+			offset += size;
+		}
 
-			if (materialNameIndex.find(material) != materialNameIndex.end())
-				materialIndex = materialNameIndex[material];
+		const auto triangles = corners.size() / 3;
 
-			std::vector<int> block(lastFace - fromFace, materialIndex);
+		std::vector<float> frame(triangles * 9); //Tangent, bitangent and normal per triangle, normalized
 
-			connect.insert(connect.end(), block.begin(), block.end());
-		}
+		parallel(triangles, 4096, [&](const size_t begin, const size_t end)
+		{
+			for (size_t triangle = begin; triangle < end; triangle++)
+			{
+				const int* index = &corners[triangle * 3];
 
-		if (connect.size() != loadOBJ.face.vertex.size())
-			connect.clear();
+				const float* p0 = xyz + weld.vertex[index[0]] * 3;
+				const float* p1 = xyz + weld.vertex[index[1]] * 3;
+				const float* p2 = xyz + weld.vertex[index[2]] * 3;
 
-		return connect.size();
-	}
+				const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+				const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
 
-	template <typename LoadMTL, class T>
-	size_t loadFaceColor(Load& loadOBJ, LoadMTL& loadMTL, std::vector<std::vector<T>>& color, const bool alpha = false)
-	{
-		T r = 0;
-		T g = 0;
-		T b = 1;
-		T a = 1;
+				float* t = &frame[triangle * 9 + 0];
+				float* b = &frame[triangle * 9 + 3];
+				float* n = &frame[triangle * 9 + 6];
 
-		color.clear();
+				n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+				n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+				n[2] = e1[0] * e2[1] - e1[1] * e2[0];
 
-		std::vector<int> faceMaterial;
+				normalize(n);
 
-		auto& materialList = loadMTL.materials();
+				t[0] = t[1] = t[2] = b[0] = b[1] = b[2] = 0.0f;
 
-		if (connectFaceMaterial(loadOBJ, loadMTL, faceMaterial) == 0)
-		{
-			std::vector<T> defaultColor;
+				if (weld.texture[index[0]] < 0 || weld.texture[index[1]] < 0 || weld.texture[index[2]] < 0)
+					continue;
 
-			if (!materialList.empty())
-			{
-				const auto& material = materialList[0];
+				const float* t0 = uv + weld.texture[index[0]] * 2;
+				const float* t1 = uv + weld.texture[index[1]] * 2;
+				const float* t2 = uv + weld.texture[index[2]] * 2;
 
-				const auto& Kd = material.Kd.color;
+				const float s1 = t1[0] - t0[0], v1 = t1[1] - t0[1];
+				const float s2 = t2[0] - t0[0], v2 = t2[1] - t0[1];
 
-				r = static_cast<T>(Kd.r);
-				g = static_cast<T>(Kd.g);
-				b = static_cast<T>(Kd.b);
+				const float area = s1 * v2 - s2 * v1;
 
-				if (alpha)
-					a = static_cast<T>(material.d.d);
+				if (std::fabs(area) < 1e-20f) continue; //Degenerate texture mapping
+
+				const float r = 1.0f / area;
+
+				for (size_t axis = 0; axis < 3; axis++)
+				{
+					t[axis] = (e1[axis] * v2 - e2[axis] * v1) * r;
+					b[axis] = (e2[axis] * s1 - e1[axis] * s2) * r;
+				}
+
+				normalize(t);
+				normalize(b);
 			}
+		});
 
-			if (alpha)
-				defaultColor = { r , g , b , a };
-			else
-				defaultColor = { r , g , b };
+		std::vector<size_t> start(vertices + 1, 0);
 
-			color = std::vector<std::vector<T>>(loadOBJ.face.vertex.size(), defaultColor);
+		for (const auto& vertex : corners)
+			start[vertex + 1]++;
 
-			return color.size();
-		}
+		for (size_t vertex = 0; vertex < vertices; vertex++)
+			start[vertex + 1] += start[vertex];
 
-		color.resize(faceMaterial.size());
+		std::vector<size_t> adjacency(corners.size()); //Triangle corners per welded vertex
+		std::vector<size_t> cursor(start.begin(), start.end() - 1);
 
-		int materialIndex(-1);
+		for (size_t corner = 0; corner < corners.size(); corner++)
+			adjacency[cursor[corners[corner]]++] = corner;
 
-		for (size_t face = 0; face < color.size(); face++)
+		tangent.resize(vertices * 4);
+
+		parallel(vertices, 4096, [&](const size_t begin, const size_t end)
 		{
-			if (materialIndex != faceMaterial[face])
+			for (size_t vertex = begin; vertex < end; vertex++)
 			{
-				if (faceMaterial[face] != -1)
+				float t[3] = { 0.0f, 0.0f, 0.0f };
+				float b[3] = { 0.0f, 0.0f, 0.0f };
+				float n[3] = { 0.0f, 0.0f, 0.0f };
+
+				for (size_t item = start[vertex]; item < start[vertex + 1]; item++)
 				{
-					materialIndex = faceMaterial[face];
+					const auto triangle = adjacency[item] / 3;
 
-					const auto& material = materialList[materialIndex];
+					int index[3];
 
-					const auto& Kd = material.Kd.color;
+					for (size_t corner = 0; corner < 3; corner++)
+						index[corner] = weld.vertex[corners[triangle * 3 + corner]];
 
-					r = static_cast<T>(Kd.r);
-					g = static_cast<T>(Kd.g);
-					b = static_cast<T>(Kd.b);
+					const float angle = cornerAngle(xyz, index, 3, static_cast<int>(adjacency[item] % 3));
 
-					if (alpha)
-						a = static_cast<T>(material.d.d);
+					for (size_t axis = 0; axis < 3; axis++)
+					{
+						t[axis] += frame[triangle * 9 + 0 + axis] * angle;
+						b[axis] += frame[triangle * 9 + 3 + axis] * angle;
+						n[axis] += frame[triangle * 9 + 6 + axis] * angle;
+					}
 				}
-			}
 
-			if (alpha)
-				color[face] = { r , g , b , a };
-			else
-				color[face] = { r , g , b };
-		}
+				if (weld.normal[vertex] >= 0)
+				{
+					const float* item = normal + weld.normal[vertex] * 3;
 
-		return color.size();
-	}
+					n[0] = item[0];
+					n[1] = item[1];
+					n[2] = item[2];
+				}
 
-	template <typename LoadMTL, class T>
-	size_t Copy(Load& loadOBJ, LoadMTL& loadMTL, std::vector<std::vector<T>>& color, const bool alpha = false)
-	{
-		return loadFaceColor(loadOBJ, loadMTL, color, alpha);
+				normalize(n);
+
+				const float dot = n[0] * t[0] + n[1] * t[1] + n[2] * t[2]; //Gram-Schmidt
+
+				for (size_t axis = 0; axis < 3; axis++)
+					t[axis] -= n[axis] * dot;
+
+				normalize(t);
+
+				const float c[3] = { n[1] * t[2] - n[2] * t[1], n[2] * t[0] - n[0] * t[2], n[0] * t[1] - n[1] * t[0] };
+
+				float* item = &tangent[vertex * 4];
+
+				item[0] = t[0];
+				item[1] = t[1];
+				item[2] = t[2];
+				item[3] = c[0] * b[0] + c[1] * b[1] + c[2] * b[2] < 0.0f ? -1.0f : 1.0f;
+			}
+		});
+
+		return vertices;
 	}
 
 	//-------------------------------------------------------------------------------------------------------
-	// Additional functions for easier copying or moving of lists from WavefrontOBJ to your working lists
+	// Additional functions for writing obj files
 	//-------------------------------------------------------------------------------------------------------
 
-	enum VertexFormat
+	// Shortest text (6 to 9 significant digits) that reads back as the same float
+	// snprintf writes the decimal point of the C locale (point), it is always written as '.'
+	inline size_t ftoa(const float value, char* text, const char point = '.')
 	{
-		xyz = 3,
-		xyzw = 4,
-		xyzrgb = 6
-	};
+		int length(0);
 
-	inline VertexFormat vertexFormat(const size_t& size)
-	{
-		switch(size)
+		float read(0);
+
+		const char* end;
+
+		for (int precision = 6; precision <= 9; precision++)
 		{
-		case 3: return xyz;
-		case 4: return xyzw;
-		case 6: return xyzrgb;
+			length = snprintf(text, 32, "%.*g", precision, static_cast<double>(value));
+
+			if (point != '.')
+			{
+				char* decimal = strchr(text, point);
+
+				if (decimal) *decimal = '.';
+			}
+
+			if (strtof(text, read, end) && *end == '\0' && read == value)
+				break;
 		}
 
-		return xyz;
+		return static_cast<size_t>(length);
+	}
+
+	inline size_t itoa(long long value, char* text)
+	{
+		char digit[24];
+
+		size_t size(0), length(0);
+
+		const bool negative = value < 0;
+
+		unsigned long long v = negative ? 0ull - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
+
+		do
+		{
+			digit[size++] = static_cast<char>('0' + v % 10);
+
+			v /= 10;
+		} while (v);
+
+		if (negative)
+			text[length++] = '-';
+
+		while (size)
+			text[length++] = digit[--size];
+
+		return length;
 	}
 
-	inline VertexFormat format(const Vertex& vertex, bool& varies)
-	{
-		varies = false;
+	class Save
+	{
+	public:
+
+		explicit Save(const Load& source);
+
+		Save(const Save&) = delete;
+
+		Save& operator=(const Save&) = delete;
 
-		if (vertex.empty()) return xyz;
+		bool save(const std::string& path);
 
-		const VertexFormat format = vertexFormat(vertex.s.front());
+	private:
 
-		for (const auto& size : vertex.s)
-		{
-			if (vertexFormat(size) != format)
-			{
-				varies = true;
+		template <typename Function>
+		bool write(FILE* file, size_t count, Function format);
 
-				return xyz;
-			}
-		}
+		const Load& source;
+	};
 
-		return format;
-	}
+	inline Save::Save(const Load& source) : source(source) { }
 
-	bool move(Vertex& source, std::vector<float>& target, const VertexFormat format = xyz)
+	// Formats items [0, count) in chunks on all hardware threads, then writes the chunks in order
+	template <typename Function>
+	bool Save::write(FILE* file, const size_t count, Function format)
 	{
-		bool varies(false);
+		const size_t chunk = 1 << 16;
 
-		if (source.empty()) return true;
+		std::vector<std::string> buffer((count + chunk - 1) / chunk);
 
-		if (obj::format(source, varies) == format && !varies)
+		parallel(buffer.size(), 1, [&](const size_t begin, const size_t end)
 		{
-			target = std::move(source.v);
+			for (size_t index = begin; index < end; index++)
+			{
+				auto& text = buffer[index];
 
-			source.clear();
+				const auto first = index * chunk;
+				const auto last = std::min(first + chunk, count);
 
-			return true;
+				text.reserve((last - first) * 40);
+
+				for (size_t item = first; item < last; item++)
+					format(item, text);
+			}
+		});
+
+		for (const auto& text : buffer)
+		{
+			if (fwrite(text.data(), sizeof(char), text.size(), file) != text.size())
+				return false;
 		}
 
-		return false;
+		return true;
 	}
 
-	size_t copy(Vertex& source, std::vector<float>& target, const VertexFormat format = xyz)
+	inline bool Save::save(const std::string& path)
 	{
-		if(move(source, target, format))
-			return target.size();
+		FILE* file = fopen(path.c_str(), "wb");
+
+		if (file == nullptr)
+			return false;
 
-		auto vertex = source.v.begin();
+		auto append = [](std::string& text, const char* item, const size_t length) { text.append(item, length); };
 
-		for (const auto& size : source.s)
+		const char point = *localeconv()->decimal_point; //Read once, localeconv is not thread safe
+
+		auto list = [&](const char* keyword, const List<float>& list, const std::vector<size_t>& offset)
 		{
-			if (format == size)
-				target.insert(target.end(), vertex, vertex + size);
-			else
+			return [&, keyword](const size_t item, std::string& text)
 			{
-				std::vector<float> item;
+				char number[32];
 
-				item.emplace_back(size > 0 ? *(vertex + 0) : 0.0f);
-				item.emplace_back(size > 1 ? *(vertex + 1) : 0.0f);
-				item.emplace_back(size > 2 ? *(vertex + 2) : 0.0f);
+				text += keyword;
 
-				if (format == xyzw)
+				for (size_t index = offset[item]; index < offset[item + 1]; index++)
 				{
-					item.emplace_back(0.0f);
-				}
+					text += ' ';
 
-				if (format == xyzrgb)
-				{
-					item.emplace_back(0.0f);
-					item.emplace_back(0.0f);
-					item.emplace_back(0.0f);
+					append(text, number, ftoa(list.v[index], number, point));
 				}
 
-				target.insert(target.end(), item.begin(), item.end());
-			}
+				text += '\n';
+			};
+		};
 
-			vertex += size;
-		}
+		std::string head;
 
-		return target.size();
-	}
+		if (!source.materialFile.empty())
+			head += "mtllib " + source.materialFile + "\n";
 
-	template <typename T>
-	size_t copy(const Vertex& source, std::vector<T>& target, const VertexFormat format = xyz)
-	{
-		auto vertex = source.v.begin();
+		auto res = fwrite(head.data(), sizeof(char), head.size(), file) == head.size();
 
-		for (const auto& size : source.s)
-		{
-			std::vector<T> item;
+		std::vector<size_t> vertexOffset, textureOffset, normalOffset;
 
-			item.emplace_back((T)(size > 0 ? *(vertex + 0) : 0));
-			item.emplace_back((T)(size > 1 ? *(vertex + 1) : 0));
-			item.emplace_back((T)(size > 2 ? *(vertex + 2) : 0));
+		offsets(source.vertex, vertexOffset);
+		offsets(source.texture, textureOffset);
+		offsets(source.normal, normalOffset);
 
-			if (format == xyzw)
-			{
-				item.emplace_back((T)(0));
-			}
+		res = res && write(file, source.vertex.size(), list("v", source.vertex, vertexOffset));
+		res = res && write(file, source.texture.size(), list("vt", source.texture, textureOffset));
+		res = res && write(file, source.normal.size(), list("vn", source.normal, normalOffset));
 
-			if (format == xyzrgb)
-			{
-				item.emplace_back((T)(0));
-				item.emplace_back((T)(0));
-				item.emplace_back((T)(0));
-			}
+		std::vector<size_t> parameterOffset;
 
-			target.insert(target.end(), item.begin(), item.end());
+		offsets(source.parameter, parameterOffset);
 
-			vertex += size;
-		}
+		res = res && write(file, source.parameter.size(), list("vp", source.parameter, parameterOffset));
 
-		return target.size();
-	}
+		std::vector<std::tuple<size_t, std::string>> record; //usemtl, #, o, g, s and free-form lines at their face
 
-	template <typename T>
-	size_t copy(const Vertex& source, std::vector<std::vector<T>>& target, const VertexFormat format = xyz)
-	{
-		auto vertex = source.v.begin();
+		for (const auto& item : source.informationFace)
+			record.emplace_back(std::get<2>(item), std::string(1, std::get<0>(item)) + " " + std::get<1>(item) + "\n");
 
-		for (const auto& size : source.s)
+		for (const auto& item : source.materialFace)
+			record.emplace_back(std::get<1>(item), "usemtl " + std::get<0>(item) + "\n");
+
+		for (const auto& item : source.recordFace)
+			record.emplace_back(std::get<2>(item), std::get<0>(item) + (std::get<1>(item).empty() ? "" : " " + std::get<1>(item)) + "\n");
+
+		std::stable_sort(record.begin(), record.end(), [](const std::tuple<size_t, std::string>& a, const std::tuple<size_t, std::string>& b) { return std::get<0>(a) < std::get<0>(b); });
+
+		const auto& face = source.face;
+
+		std::vector<size_t> faceVertex, faceTexture, faceNormal;
+
+		offsets(face.vertex, faceVertex);
+		offsets(face.texture, faceTexture);
+		offsets(face.normal, faceNormal);
+
+		const auto faces = face.vertex.size();
+
+		res = res && write(file, faces + 1, [&](const size_t item, std::string& text)
 		{
-			std::vector<T> item;
+			auto find = std::lower_bound(record.begin(), record.end(), item, [](const std::tuple<size_t, std::string>& a, const size_t b) { return std::get<0>(a) < b; });
 
-			item.emplace_back((T)(size > 0 ? *(vertex + 0) : 0));
-			item.emplace_back((T)(size > 1 ? *(vertex + 1) : 0));
-			item.emplace_back((T)(size > 2 ? *(vertex + 2) : 0));
+			for (; find != record.end() && (std::get<0>(*find) == item || (item == faces && std::get<0>(*find) > faces)); ++find)
+				text += std::get<1>(*find);
 
-			if (format == xyzw)
-			{
-				item.emplace_back((T)(0));
-			}
+			if (item == faces) return; //Records after the last face
 
-			if (format == xyzrgb)
-			{
-				item.emplace_back((T)(0));
-				item.emplace_back((T)(0));
-				item.emplace_back((T)(0));
-			}
+			char number[24];
 
-			target.emplace_back(item);
+			const auto size = face.vertex.s[item];
 
-			vertex += size;
-		}
+			const auto hasTexture = item < face.texture.size() && face.texture.s[item] == size;
+			const auto hasNormal = item < face.normal.size() && face.normal.s[item] == size;
 
-		return target.size();
-	}
+			text += 'f';
 
-	bool move(Normal& source, std::vector<float>& target)
-	{
-		if (source.empty()) return true;
+			for (int corner = 0; corner < size; corner++)
+			{
+				text += ' ';
 
-		for (const auto& size : source.s)
-		{
-			if (size != xyz)
-				return false;
-		}
+				append(text, number, itoa(face.vertex.v[faceVertex[item] + corner] + 1ll, number));
 
-		target = std::move(source.v);
+				if (hasTexture || hasNormal)
+					text += '/';
 
-		source.clear();
+				if (hasTexture)
+					append(text, number, itoa(face.texture.v[faceTexture[item] + corner] + 1ll, number));
 
-		return true;
-	}
+				if (hasNormal)
+				{
+					text += '/';
 
-	size_t copy(Normal& source, std::vector<float>& target)
-	{
-		if (move(source, target))
-			return target.size();
+					append(text, number, itoa(face.normal.v[faceNormal[item] + corner] + 1ll, number));
+				}
+			}
 
-		auto normal = source.v.begin();
+			text += '\n';
+		});
 
-		for (const auto& size : source.s)
+		auto indices = [&](const char* keyword, const List<int>& vertex, const List<int>* texture)
 		{
-			if (size == 3)
-				target.insert(target.end(), normal, normal + size);
-			else
+			std::vector<size_t> vertexOffset, textureOffset;
+
+			offsets(vertex, vertexOffset);
+
+			if (texture)
+				offsets(*texture, textureOffset);
+
+			return write(file, vertex.size(), [&](const size_t item, std::string& text)
 			{
-				std::vector<float> item;
+				char number[24];
 
-				item.emplace_back(size > 0 ? *(normal + 0) : 0.0f);
-				item.emplace_back(size > 1 ? *(normal + 1) : 0.0f);
-				item.emplace_back(size > 2 ? *(normal + 2) : 0.0f);
+				const auto size = vertex.s[item];
 
-				target.insert(target.end(), item.begin(), item.end());
-			}
+				const auto hasTexture = texture && item < texture->size() && texture->s[item] == size;
 
-			normal += size;
-		}
+				text += keyword;
 
-		return target.size();
+				for (int corner = 0; corner < size; corner++)
+				{
+					text += ' ';
+
+					append(text, number, itoa(vertex.v[vertexOffset[item] + corner] + 1ll, number));
+
+					if (hasTexture)
+					{
+						text += '/';
+
+						append(text, number, itoa(texture->v[textureOffset[item] + corner] + 1ll, number));
+					}
+				}
+
+				text += '\n';
+			});
+		};
+
+		res = res && indices("l", source.line.vertex, &source.line.texture);
+		res = res && indices("p", source.point.vertex, nullptr);
+
+		fclose(file);
+
+		return res;
 	}
 
-	template <typename T>
-	size_t copy(const Normal& source, std::vector<T>& target)
+	//-------------------------------------------------------------------------------------------------------
+	// Additional functions for quantizing vertices, normals and texture vertices for streaming
+	//-------------------------------------------------------------------------------------------------------
+
+	inline unsigned short floatToHalf(const float value)
 	{
-		auto normal = source.v.begin();
+		unsigned int bits;
 
-		for (const auto& size : source.s)
+		memcpy(&bits, &value, sizeof(bits));
+
+		const auto sign = static_cast<unsigned short>((bits >> 16) & 0x8000);
+
+		const unsigned int magnitude = bits & 0x7FFFFFFF;
+
+		if (magnitude >= 0x7F800000) //Inf or NaN
+			return static_cast<unsigned short>(sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0));
+
+		if (magnitude >= 0x477FF000) //Rounds to inf
+			return static_cast<unsigned short>(sign | 0x7C00);
+
+		if (magnitude < 0x38800000) //Subnormal half or zero
 		{
-			std::vector<T> item;
+			if (magnitude < 0x33000000) return sign;
 
-			item.emplace_back((T)(size > 0 ? *(normal + 0) : 0));
-			item.emplace_back((T)(size > 1 ? *(normal + 1) : 0));
-			item.emplace_back((T)(size > 2 ? *(normal + 2) : 0));
+			const unsigned int shift = 126 - (magnitude >> 23);
 
-			target.insert(target.end(), item.begin(), item.end());
+			const unsigned int mantissa = (magnitude & 0x7FFFFF) | 0x800000;
 
-			normal += size;
+			unsigned int half = mantissa >> shift;
+
+			const unsigned int rest = mantissa & ((1u << shift) - 1);
+			const unsigned int halfway = 1u << (shift - 1);
+
+			if (rest > halfway || (rest == halfway && (half & 1))) half++; //Round to nearest even
+
+			return static_cast<unsigned short>(sign | half);
 		}
 
-		return target.size();
+		unsigned int half = (magnitude - 0x38000000) >> 13;
+
+		const unsigned int rest = magnitude & 0x1FFF;
+
+		if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+
+		return static_cast<unsigned short>(sign | half);
 	}
 
-	template <typename T>
-	size_t copy(const Normal& source, std::vector<std::vector<T>>& target)
+	inline float halfToFloat(const unsigned short half)
 	{
-		auto normal = source.v.begin();
+		const unsigned int sign = static_cast<unsigned int>(half & 0x8000) << 16;
+		const unsigned int exponent = (half >> 10) & 0x1F;
+		const unsigned int mantissa = half & 0x3FF;
 
-		for (const auto& size : source.s)
+		if (exponent == 0)
 		{
-			std::vector<T> item;
+			const float value = static_cast<float>(mantissa) * 5.9604644775390625e-8f; //2^-24
 
-			item.emplace_back((T)(size > 0 ? *(normal + 0) : 0));
-			item.emplace_back((T)(size > 1 ? *(normal + 1) : 0));
-			item.emplace_back((T)(size > 2 ? *(normal + 2) : 0));
+			return sign ? -value : value;
+		}
 
-			target.emplace_back(item);
+		const unsigned int bits = exponent == 31 ? sign | 0x7F800000 | (mantissa << 13) : sign | ((exponent + 112) << 23) | (mantissa << 13);
 
-			normal += size;
-		}
+		float value;
 
-		return target.size();
+		memcpy(&value, &bits, sizeof(value));
+
+		return value;
 	}
 
-	enum TextureFormat
+	inline void convertHalf(const float* source, const size_t count, unsigned short* target)
 	{
-		uv = 2,
-		uvw = 3
-	};
+		for (size_t index = 0; index < count; index++)
+			target[index] = floatToHalf(source[index]);
+	}
 
-	inline TextureFormat textureFormat(const size_t& size)
+	// Copies the first components of every item as half floats to a caller provided buffer of capacity items
+	inline size_t copyHalf(const List<float>& source, const int components, unsigned short* target, const size_t capacity)
 	{
-		return size == 2 ? uv : uvw;
+		if (capacity < source.size()) return 0;
+
+		std::vector<float> scratch;
+
+		convertHalf(obj::components(source, components, scratch), source.size() * components, target);
+
+		return source.size();
 	}
 
-	inline TextureFormat format(const Texture& texture, bool& varies)
+	inline short snorm16(const float value)
 	{
-		varies = false;
+		return static_cast<short>(std::floor(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f + 0.5f));
+	}
 
-		if (texture.empty()) return uv;
+	// Octahedral mapping of a unit vector to two 16 bit snorm values
+	inline void octahedron(const float* normal, short* xy)
+	{
+		float n[3] = { normal[0], normal[1], normal[2] };
 
-		const TextureFormat format = textureFormat(texture.s.front());
+		const float length = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
 
-		for (const auto& size : texture.s)
+		float x = length > 0.0f ? n[0] / length : 0.0f;
+		float y = length > 0.0f ? n[1] / length : 0.0f;
+
+		if (n[2] < 0.0f)
 		{
-			if (textureFormat(size) != format)
-			{
-				varies = true;
+			const float u = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			const float v = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
 
-				return uv;
-			}
+			x = u;
+			y = v;
 		}
 
-		return format;
+		xy[0] = snorm16(x);
+		xy[1] = snorm16(y);
 	}
 
-	bool move(Texture& source, std::vector<float>& target, const TextureFormat format = uvw)
+	inline void octahedron(const short* xy, float* normal)
 	{
-		bool varies(false);
+		float x = std::max(-1.0f, xy[0] / 32767.0f);
+		float y = std::max(-1.0f, xy[1] / 32767.0f);
 
-		if (source.empty()) return true;
+		const float z = 1.0f - std::fabs(x) - std::fabs(y);
 
-		if (obj::format(source, varies) == format && !varies)
+		if (z < 0.0f)
 		{
-			target = std::move(source.v);
-
-			source.clear();
+			const float u = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			const float v = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
 
-			return true;
+			x = u;
+			y = v;
 		}
 
-		return false;
+		normal[0] = x;
+		normal[1] = y;
+		normal[2] = z;
+
+		normalize(normal);
 	}
 
-	size_t copy(Texture& source, std::vector<float>& target, const TextureFormat format = uvw)
+	struct Quantized
 	{
-		if (move(source, target, format))
-			return target.size();
-
-		auto texture = source.v.begin();
+		void clear();
 
-		for (const auto& size : source.s)
-		{
-			if (format == size)
-				target.insert(target.end(), texture, texture + size);
-			else
-			{
-				std::vector<float> item;
+		std::vector<unsigned short> vertex;  //x, y, z as 16 bit unorm, vertex = offset + q * scale
+		std::vector<short>          normal;  //Octahedral x, y as 16 bit snorm
+		std::vector<unsigned short> texture; //u, v as half floats
 
-				item.emplace_back(size > 0 ? *(texture + 0) : 0.0f);
-				item.emplace_back(size > 1 ? *(texture + 1) : 0.0f);
+		float offset[3];
+		float scale[3];
 
-				if (format == uvw)
-					item.emplace_back(size > 2 ? *(texture + 2) : 1.0f);
+		float vertexError;  //Max distance along an axis
+		float normalError;  //Max angle in radians
+		float textureError; //Max absolute difference
+	};
 
-				target.insert(target.end(), item.begin(), item.end());
-			}
+	inline void Quantized::clear()
+	{
+		vertex.clear();
+		normal.clear();
+		texture.clear();
 
-			texture += size;
-		}
+		for (size_t axis = 0; axis < 3; axis++)
+			offset[axis] = scale[axis] = 0.0f;
 
-		return target.size();
+		vertexError = normalError = textureError = 0.0f;
 	}
 
 	template <typename T>
-	size_t copy(const Texture& source, std::vector<T>& target, const TextureFormat format = uvw)
+	void release(List<T>& list)
 	{
-		auto texture = source.v.begin();
+		std::vector<T>().swap(list.v);
+		std::vector<int>().swap(list.s);
+	}
 
-		for (const auto& size : source.s)
+	// Quantizes vertex, normal and texture lists. With release set, each float list is freed as soon as it is
+	// quantized. Uses obj.bounds when loaded with LoadOption::extents.
+	inline size_t quantize(Load& loadOBJ, Quantized& quantized, const bool release = false)
+	{
+		quantized.clear();
+
+		std::vector<float> scratch;
+
+		const auto vertices = loadOBJ.vertex.size();
+
+		if (vertices)
 		{
-			std::vector<T> item;
+			const float* xyz = vertexPositions(loadOBJ.vertex, scratch);
 
-			item.emplace_back((T)(size > 0 ? *(texture + 0) : 0));
-			item.emplace_back((T)(size > 1 ? *(texture + 1) : 0));
+			Bounds bounds = loadOBJ.bounds;
 
-			if (format == uvw)
-				item.emplace_back((T)(size > 2 ? *(texture + 2) : 1));
+			if (bounds.count != vertices)
+			{
+				bounds.clear();
 
-			target.insert(target.end(), item.begin(), item.end());
+				for (size_t index = 0; index < vertices; index++)
+					bounds.insert(xyz + index * 3);
+			}
 
-			texture += size;
-		}
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				quantized.offset[axis] = bounds.minimum[axis];
+				quantized.scale[axis] = (bounds.maximum[axis] - bounds.minimum[axis]) / 65535.0f;
+			}
 
-		return target.size();
-	}
+			quantized.vertex.resize(vertices * 3);
 
-	template <typename T>
-	size_t copy(const Texture& source, std::vector<std::vector<T>>& target, const TextureFormat format = uvw)
-	{
-		auto texture = source.v.begin();
+			for (size_t index = 0; index < vertices * 3; index++)
+			{
+				const auto axis = index % 3;
 
-		for (const auto& size : source.s)
-		{
-			std::vector<T> item;
+				const float scale = quantized.scale[axis];
 
-			item.emplace_back((T)(size > 0 ? *(texture + 0) : 0));
-			item.emplace_back((T)(size > 1 ? *(texture + 1) : 0));
+				const float q = scale > 0.0f ? std::floor((xyz[index] - quantized.offset[axis]) / scale + 0.5f) : 0.0f;
 
-			if (format == uvw)
-				item.emplace_back((T)(size > 2 ? *(texture + 2) : 1));
+				quantized.vertex[index] = static_cast<unsigned short>(std::max(0.0f, std::min(65535.0f, q)));
 
-			target.emplace_back(item);
+				const float error = std::fabs(quantized.offset[axis] + quantized.vertex[index] * scale - xyz[index]);
 
-			texture += size;
+				quantized.vertexError = std::max(quantized.vertexError, error);
+			}
+
+			if (release)
+			{
+				obj::release(loadOBJ.vertex);
+
+				std::vector<float>().swap(scratch);
+			}
 		}
 
-		return target.size();
-	}
+		const auto normals = loadOBJ.normal.size();
 
-	bool move(List<int>& source, std::vector<int>& target)
-	{
-		if (source.empty()) return true;
+		if (normals)
+		{
+			const float* normal = components(loadOBJ.normal, 3, scratch);
 
-		target = std::move(source.v);
+			quantized.normal.resize(normals * 2);
 
-		source.clear();
+			for (size_t index = 0; index < normals; index++)
+			{
+				float n[3] = { normal[index * 3 + 0], normal[index * 3 + 1], normal[index * 3 + 2] };
 
-		return true;
-	}
+				normalize(n);
 
-	inline size_t copy(List<int>& source, std::vector<int>& target)
-	{
-		return move(source, target) ? target.size() : 0;
-	}
+				octahedron(n, &quantized.normal[index * 2]);
 
-	inline size_t copy(const List<int>& source, std::vector<std::vector<int>>& target)
-	{
-		auto item = source.v.begin();
+				float decoded[3];
 
-		for (const auto& size : source.s)
+				octahedron(&quantized.normal[index * 2], decoded);
+
+				const float dot = std::max(-1.0f, std::min(1.0f, n[0] * decoded[0] + n[1] * decoded[1] + n[2] * decoded[2]));
+
+				quantized.normalError = std::max(quantized.normalError, std::acos(dot));
+			}
+
+			if (release)
+			{
+				obj::release(loadOBJ.normal);
+
+				std::vector<float>().swap(scratch);
+			}
+		}
+
+		const auto textures = loadOBJ.texture.size();
+
+		if (textures)
 		{
-			target.emplace_back(item, item + size);
+			const float* uv = components(loadOBJ.texture, 2, scratch);
 
-			item += size;
+			quantized.texture.resize(textures * 2);
+
+			for (size_t index = 0; index < textures * 2; index++)
+			{
+				quantized.texture[index] = floatToHalf(uv[index]);
+
+				const float error = std::fabs(halfToFloat(quantized.texture[index]) - uv[index]);
+
+				quantized.textureError = std::max(quantized.textureError, error);
+			}
+
+			if (release)
+				obj::release(loadOBJ.texture);
 		}
 
-		return target.size();
+		return vertices;
 	}
 }
 
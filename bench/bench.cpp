@@ -0,0 +1,411 @@
+/*
+  Synthetic load benchmark for WavefrontOBJ.h
+
+  Build: g++ -std=c++11 -O2 -pthread bench/bench.cpp -o bench
+  Usage: bench [runs] [grid]
+
+  Generates deterministic OBJ files and prints load, stage, copy and
+  conversion measurements as JSON, one object per file. Each file is
+  loaded by the program started again as: bench runs grid name, so the
+  peak memory of one file is not hidden by a larger file before it.
+ */
+
+#define WAVEFRONT_OBJ_PROFILE //Row counters and list reallocations in obj::Profile
+#include "../WavefrontOBJ.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <new>
+#include <functional>
+#include <cstdlib>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std::chrono;
+
+std::atomic<size_t> allocations(0);
+
+void* operator new(size_t size)
+{
+	allocations++;
+
+	if (void* memory = malloc(size)) return memory;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+size_t peakMemory() // Bytes
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+
+	return counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+
+	getrusage(RUSAGE_SELF, &usage);
+
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+struct Synthetic
+{
+	std::string name;
+	int grid;        // grid x grid vertices
+	bool texture;    // write vt and use it in faces
+	bool normal;     // write vn and use it in faces
+	int polygon;     // 3 = triangles, 4 = quads, n > 4 = n-gon fans
+	bool negative;   // relative indices
+	int comments;    // one comment every n rows, 0 = none
+};
+
+void generate(const Synthetic& test, const std::string& path)
+{
+	std::mt19937 random(1234); // Same file every run
+
+	std::uniform_real_distribution<float> jitter(-0.001f, 0.001f);
+
+	std::ofstream file(path.c_str());
+
+	int rows(0);
+
+	auto comment = [&]()
+	{
+		if (test.comments && ++rows % test.comments == 0) file << "# synthetic comment row " << rows << "\n";
+	};
+
+	const int n = test.grid;
+
+	for (int y = 0; y < n; y++)
+		for (int x = 0; x < n; x++)
+		{
+			file << "v " << x + jitter(random) << " " << y + jitter(random) << " " << jitter(random) << "\n";
+
+			if (test.texture) file << "vt " << float(x) / n << " " << float(y) / n << "\n";
+
+			if (test.normal) file << "vn " << jitter(random) << " " << jitter(random) << " 1\n";
+
+			comment();
+		}
+
+	const int vertices = n * n;
+
+	auto index = [&](int x, int y)
+	{
+		const int i = y * n + x + 1;
+
+		const int v = test.negative ? i - vertices - 1 : i;
+
+		std::ostringstream s;
+
+		s << v;
+
+		if (test.texture && test.normal) s << "/" << v << "/" << v;
+		else if (test.texture) s << "/" << v;
+		else if (test.normal) s << "//" << v;
+
+		return s.str();
+	};
+
+	const int step = test.polygon > 4 ? test.polygon - 2 : 1; // n-gons walk along a row
+
+	for (int y = 0; y + 1 < n; y++)
+		for (int x = 0; x + step < n; x += step)
+		{
+			if (test.polygon == 3)
+			{
+				file << "f " << index(x, y) << " " << index(x + 1, y) << " " << index(x + 1, y + 1) << "\n";
+				file << "f " << index(x, y) << " " << index(x + 1, y + 1) << " " << index(x, y + 1) << "\n";
+			}
+			else
+			{
+				file << "f";
+
+				for (int i = 0; i <= step; i++) file << " " << index(x + i, y);
+
+				for (int i = step; i >= 0; i--) file << " " << index(x + i, y + 1);
+
+				file << "\n";
+			}
+
+			comment();
+		}
+}
+
+struct Result
+{
+	double load = 0;          // Milliseconds
+	double progress = 0;      // Milliseconds, load with a progress callback
+	double copy = 0;          // Milliseconds
+	double megabytes = 0;     // Per second
+	size_t allocations = 0;   // Per load
+	size_t peak = 0;          // Bytes, process peak after the first load
+	double stage[4] = {};     // Milliseconds in open, read, document and parse
+	size_t stageAlloc[4] = {}; // Allocations in open, read, document and parse
+	size_t reallocations = 0; // List storage growth while parsing
+	size_t memory = 0;        // Bytes held when parsing ends
+	std::vector<std::pair<std::string, double>> convert; // MB per second of source floats or indices, per conversion
+};
+
+const char* stages[] = { "open", "read", "document", "parse" };
+
+struct Conversion
+{
+	std::string name;
+	size_t bytes;                   // Source bytes read
+	std::function<void()> function;
+};
+
+// Each copy from a const Load, so the conversion kernels run instead of moving the lists
+std::vector<Conversion> conversions(const obj::Load& obj, const obj::Vertex& color, const obj::Vertex& mixed)
+{
+	static std::vector<float> vertex, normal, texture;
+	static std::vector<double> precise;
+	static std::vector<unsigned short> half;
+	static std::vector<uint32_t> index;
+
+	const size_t vertices = obj.vertex.v.size() * sizeof(float);
+	const size_t colors = color.v.size() * sizeof(float);
+	const size_t mixeds = mixed.v.size() * sizeof(float);
+	const size_t normals = obj.normal.v.size() * sizeof(float);
+	const size_t textures = obj.texture.v.size() * sizeof(float);
+	const size_t indices = obj.face.vertex.v.size() * sizeof(int);
+
+	std::vector<Conversion> list =
+	{
+		{ "vertex_xyz",        vertices, [&]() { vertex.clear(); obj::copy(obj.vertex, vertex); } },
+		{ "vertex_xyz_double", vertices, [&]() { precise.clear(); obj::copy(obj.vertex, precise); } },
+		{ "vertex_xyzw",       vertices, [&]() { vertex.clear(); obj::copy(obj.vertex, vertex, obj::xyzw); } },
+		{ "vertex_xyzrgb_xyz", colors,   [&]() { vertex.clear(); obj::copy(color, vertex, obj::xyz); } },
+		{ "vertex_mixed_xyz",  mixeds,   [&]() { vertex.clear(); obj::copy(mixed, vertex, obj::xyz); } },
+		{ "vertex_half",       vertices, [&]() { half.resize(obj.vertex.size() * 3); obj::copyHalf(obj.vertex, 3, half.data(), obj.vertex.size()); } },
+		{ "index_uint32",      indices,  [&]() { obj::copy(obj.face.vertex, index, obj.vertex.size()); } },
+	};
+
+	if (!obj.normal.empty())
+	{
+		list.push_back({ "normal_xyz",        normals, [&]() { normal.clear(); obj::copy(obj.normal, normal); } });
+		list.push_back({ "normal_xyz_double", normals, [&]() { precise.clear(); obj::copy(obj.normal, precise); } });
+	}
+
+	if (!obj.texture.empty())
+	{
+		list.push_back({ "texture_uv",   textures, [&]() { texture.clear(); obj::copy(obj.texture, texture, obj::uv); } });
+		list.push_back({ "texture_uvw",  textures, [&]() { texture.clear(); obj::copy(obj.texture, texture, obj::uvw); } });
+		list.push_back({ "texture_half", textures, [&]() { half.resize(obj.texture.size() * 2); obj::copyHalf(obj.texture, 2, half.data(), obj.texture.size()); } });
+	}
+
+	return list;
+}
+
+Result run(const std::string& path, int runs)
+{
+	struct stat info;
+
+	if (::stat(path.c_str(), &info) != 0) return Result();
+
+	Result result;
+
+	for (int count = 0; count < runs; count++)
+	{
+		obj::Load obj(true);
+
+		obj.counter = []() { return allocations.load(); };
+
+		const size_t before = allocations;
+
+		auto start = high_resolution_clock::now();
+
+		if (!obj.load(path)) return Result();
+
+		auto stop = high_resolution_clock::now();
+
+		if (count == 0) // Before the conversion lists below add to it
+			result.peak = peakMemory();
+
+		result.allocations += allocations - before;
+
+		result.load += duration<double, std::milli>(stop - start).count();
+
+		const obj::Profile& profile = obj.profile;
+
+		const double times[] = { profile.open, profile.read, profile.document, profile.parse };
+
+		for (int stage = 0; stage < 4; stage++)
+		{
+			result.stage[stage] += times[stage];
+
+			result.stageAlloc[stage] += profile.counter[stage];
+		}
+
+		result.reallocations = profile.reallocations;
+
+		result.memory = profile.memory;
+
+		obj::Load reported(true); //Same load with a callback, for the cost of the progress checks
+
+		reported.progress = [](const obj::Progress&) {};
+
+		start = high_resolution_clock::now();
+
+		if (!reported.load(path)) return Result();
+
+		stop = high_resolution_clock::now();
+
+		result.progress += duration<double, std::milli>(stop - start).count();
+
+		const obj::Load& source = obj; //The non-const overloads move the lists instead of converting them
+
+		std::vector<float> vertex;
+		std::vector<float> texture;
+		std::vector<float> normal;
+		std::vector<uint32_t> index;
+
+		start = high_resolution_clock::now();
+
+		obj::copy(source.vertex, vertex);
+		obj::copy(source.texture, texture);
+		obj::copy(source.normal, normal);
+		obj::copy(source.face.vertex, index, source.vertex.size());
+
+		stop = high_resolution_clock::now();
+
+		result.copy += duration<double, std::milli>(stop - start).count();
+
+		obj::Vertex color, mixed; //xyzrgb, and xyz with every 16th vertex xyzw so the scalar path is taken
+
+		for (size_t item = 0; item < source.vertex.size(); item++)
+		{
+			const float* xyz = &source.vertex.v[item * 3];
+
+			const float rgb[6] = { xyz[0], xyz[1], xyz[2], 0.5f, 0.5f, 0.5f };
+
+			color.v.insert(color.v.end(), rgb, rgb + 6);
+			color.s.push_back(6);
+
+			mixed.v.insert(mixed.v.end(), rgb, rgb + (item % 16 ? 3 : 4));
+			mixed.s.push_back(item % 16 ? 3 : 4);
+		}
+
+		const auto list = conversions(source, color, mixed);
+
+		result.convert.resize(list.size());
+
+		for (size_t item = 0; item < list.size(); item++)
+		{
+			start = high_resolution_clock::now();
+
+			list[item].function();
+
+			stop = high_resolution_clock::now();
+
+			result.convert[item].first = list[item].name;
+
+			result.convert[item].second += (list[item].bytes / (1024.0 * 1024.0)) / duration<double>(stop - start).count() / runs;
+		}
+	}
+
+	result.load /= runs;
+	result.progress /= runs;
+	result.copy /= runs;
+	result.allocations /= runs;
+
+	for (int stage = 0; stage < 4; stage++)
+	{
+		result.stage[stage] /= runs;
+
+		result.stageAlloc[stage] /= runs;
+	}
+	result.megabytes = (info.st_size / (1024.0 * 1024.0)) / (result.load / 1000.0);
+
+	return result;
+}
+
+void print(const std::string& name, int runs, const Result& result)
+{
+	std::cout << "  { \"name\": \"" << name << "\", \"runs\": " << runs
+			  << ", \"load_ms\": " << result.load
+			  << ", \"progress_load_ms\": " << result.progress
+			  << ", \"copy_ms\": " << result.copy
+			  << ", \"mb_per_s\": " << result.megabytes
+			  << ", \"allocations\": " << result.allocations
+			  << ", \"peak_load_bytes\": " << result.peak
+			  << ", \"memory_bytes\": " << result.memory
+			  << ", \"reallocations\": " << result.reallocations;
+
+	for (int stage = 0; stage < 4; stage++)
+		std::cout << ", \"" << stages[stage] << "_ms\": " << result.stage[stage]
+				  << ", \"" << stages[stage] << "_allocations\": " << result.stageAlloc[stage];
+
+	std::cout << ", \"convert_mb_per_s\": {";
+
+	for (size_t item = 0; item < result.convert.size(); item++)
+		std::cout << (item ? ", \"" : " \"") << result.convert[item].first << "\": " << result.convert[item].second;
+
+	std::cout << " } }" << std::flush;
+}
+
+int main(int argc, char* argv[])
+{
+	const int runs = argc > 1 ? atoi(argv[1]) : 10;
+
+	const int grid = argc > 2 ? atoi(argv[2]) : 1000;
+
+	std::vector<Synthetic> tests =
+	{
+		{ "triangles",       grid, false, false, 3, false, 0  },
+		{ "triangles-full",  grid, true,  true,  3, false, 0  },
+		{ "quads",           grid, true,  true,  4, false, 0  },
+		{ "ngons",           grid, true,  false, 8, false, 0  },
+		{ "negative",        grid, true,  true,  4, true,  0  },
+		{ "comments",        grid, false, true,  3, false, 2  },
+	};
+
+	if (argc > 3) // One file in this process, the file is written by the parent
+	{
+		const std::string name = argv[3];
+
+		print(name, runs, run(name + ".obj", runs));
+
+		return 0;
+	}
+
+	std::cout << "[" << std::endl;
+
+	for (size_t i = 0; i < tests.size(); i++)
+	{
+		const std::string path = tests[i].name + ".obj";
+
+		generate(tests[i], path);
+
+		std::ostringstream command;
+
+		command << "\"" << argv[0] << "\" " << runs << " " << grid << " " << tests[i].name;
+
+		if (std::system(command.str().c_str()) != 0)
+			std::cerr << "Failed: " << command.str() << std::endl;
+
+		std::cout << (i + 1 < tests.size() ? "," : "") << std::endl;
+
+		remove(path.c_str());
+	}
+
+	std::cout << "]" << std::endl;
+
+	return 0;
+}
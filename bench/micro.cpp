@@ -0,0 +1,194 @@
+/*
+  Microbenchmark of the WavefrontOBJ.h number parsers, trim and parse overloads
+
+  Build: g++ -std=c++11 -O2 -pthread bench/micro.cpp -o micro
+ */
+
+#include "../WavefrontOBJ.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+using namespace std::chrono;
+
+size_t sink(0); // Keeps the optimizer from removing the work
+
+struct Corpus
+{
+	std::string name;
+	std::vector<std::string> lines;
+	size_t bytes() const { size_t n(0); for (const auto& line : lines) n += line.size(); return n; }
+};
+
+// Calls pass(corpus) until at least 200 ms have passed, then prints ns per line and MB/s
+template<typename Pass>
+void benchmark(const std::string& name, const Corpus& corpus, Pass pass)
+{
+	pass(corpus); // Warm up
+
+	size_t passes(0);
+
+	const auto start = steady_clock::now();
+
+	auto stop = start;
+
+	while (stop - start < milliseconds(200))
+	{
+		pass(corpus);
+
+		passes++;
+
+		stop = steady_clock::now();
+	}
+
+	const auto seconds = duration<double>(stop - start).count();
+
+	const auto lines = static_cast<double>(passes * corpus.lines.size());
+
+	std::cout << std::left << std::setw(40) << (name + "/" + corpus.name)
+			  << std::right << std::setw(10) << std::fixed << std::setprecision(1) << seconds * 1e9 / lines << " ns/line"
+			  << std::setw(10) << passes * corpus.bytes() / seconds / (1024 * 1024) << " MB/s" << std::endl;
+}
+
+Corpus numbers(const std::string& name, const char* format, const bool integer, int count)
+{
+	Corpus corpus{ name, {} };
+
+	char text[64];
+
+	for (int index = 0; index < count; index++)
+	{
+		const int value = (index * 7919) % 100000 - 50000;
+
+		if (integer)
+			snprintf(text, sizeof(text), format, value);
+		else
+			snprintf(text, sizeof(text), format, value / 97.0);
+
+		corpus.lines.push_back(text);
+	}
+
+	return corpus;
+}
+
+Corpus elements(const std::string& name, const int corners, const char* pattern, const bool negative, int count)
+{
+	Corpus corpus{ name, {} };
+
+	const std::string format(pattern); // "v/vt/vn", "v//vn", "v/vt" or "v"
+
+	for (int index = 0; index < count; index++)
+	{
+		std::string line;
+
+		for (int corner = 0; corner < corners; corner++)
+		{
+			const int item = negative ? -(corner + 1) : (index + corner) % 1000 + 1;
+
+			const std::string number = std::to_string(item);
+
+			if (corner) line += " ";
+
+			line += number;
+
+			if (format == "v/vt/vn") line += "/" + number + "/" + number;
+			if (format == "v//vn") line += "//" + number;
+			if (format == "v/vt") line += "/" + number;
+		}
+
+		corpus.lines.push_back(line);
+	}
+
+	return corpus;
+}
+
+int main()
+{
+	const int count = 4096;
+
+	const Corpus decimal = numbers("decimal", "%.6f", false, count);
+	const Corpus scientific = numbers("scientific", "%.6e", false, count);
+	const Corpus integer = numbers("integer", "%d", true, count);
+	const Corpus vertex = numbers("v", "%.6f 1.5 -2.25", false, count);
+	const Corpus padded = numbers("padded", "  %.6f 1.5 -2.25  \t ", false, count);
+
+	const Corpus triangle = elements("f v/vt/vn", 3, "v/vt/vn", false, count);
+	const Corpus quad = elements("f v/vt/vn quad", 4, "v/vt/vn", false, count);
+	const Corpus normal = elements("f v//vn", 3, "v//vn", false, count);
+	const Corpus plain = elements("f v", 3, "v", false, count);
+	const Corpus relative = elements("f negative", 3, "v/vt/vn", true, count);
+	const Corpus line = elements("l v/vt", 2, "v/vt", false, count);
+
+	for (const Corpus* corpus : { &decimal, &scientific, &integer })
+		benchmark("strtof", *corpus, [](const Corpus& corpus)
+		{
+			float value;
+			const char* end;
+			for (const auto& text : corpus.lines)
+				sink += obj::strtof(text.c_str(), value, end) ? static_cast<size_t>(value) : 0;
+		});
+
+	benchmark("strtoi", integer, [](const Corpus& corpus)
+		{
+			int value;
+			const char* end;
+			for (const auto& text : corpus.lines)
+				sink += obj::strtoi(text.c_str(), value, end) ? static_cast<size_t>(value) : 0;
+		});
+
+	benchmark("trim", padded, [](const Corpus& corpus) // Includes copying each line, trim writes to it
+	{
+		char text[128];
+		for (const auto& line : corpus.lines)
+		{
+			memcpy(text, line.c_str(), line.size() + 1);
+			sink += *obj::trim(text);
+		}
+	});
+
+	benchmark("parse Vertex", vertex, [](const Corpus& corpus)
+	{
+		obj::Vertex list;
+		for (const auto& text : corpus.lines)
+			obj::parse(text.c_str(), list);
+		sink += list.size();
+	});
+
+	benchmark("parse Texture", vertex, [](const Corpus& corpus)
+	{
+		obj::Texture list;
+		for (const auto& text : corpus.lines)
+			obj::parse(text.c_str(), list);
+		sink += list.size();
+	});
+
+	benchmark("parse Normal", vertex, [](const Corpus& corpus)
+	{
+		obj::Normal list;
+		for (const auto& text : corpus.lines)
+			obj::parse(text.c_str(), list);
+		sink += list.size();
+	});
+
+	for (const Corpus* corpus : { &triangle, &quad, &normal, &plain, &relative })
+		for (bool triangulate : { false, true })
+			benchmark(triangulate ? "parse Face triangulate" : "parse Face", *corpus, [triangulate](const Corpus& corpus)
+			{
+				obj::Face list;
+				for (const auto& text : corpus.lines)
+					obj::parse(text.c_str(), list, triangulate);
+				sink += list.vertex.size();
+			});
+
+	benchmark("parse Line", line, [](const Corpus& corpus)
+	{
+		obj::Line list;
+		for (const auto& text : corpus.lines)
+			obj::parse(text.c_str(), list);
+		sink += list.vertex.size();
+	});
+
+	std::cout << "(" << sink % 10 << ")" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,348 @@
+/*
+  Fuzz and differential test of WavefrontOBJ.h
+
+  Build: g++ -std=c++11 -O1 -g -pthread -fsanitize=address,undefined fuzz/fuzz.cpp -o fuzz
+  libFuzzer: clang++ -std=c++11 -g -DFUZZER -fsanitize=fuzzer,address,undefined fuzz/fuzz.cpp -o fuzz
+  Usage: fuzz [runs] [seed]
+ */
+
+#include "../WavefrontOBJ.h"
+#include <iostream>
+#include <sstream>
+#include <random>
+#include <cstdint>
+
+// Checks that hold for any input the parser accepts
+bool consistent(const obj::Load& obj)
+{
+	auto sized = [](const obj::List<int>& list)
+	{
+		size_t count(0);
+		for (const auto size : list.s) count += static_cast<size_t>(size);
+		return count == list.v.size();
+	};
+
+	if (!sized(obj.face.vertex) || !sized(obj.face.texture) || !sized(obj.face.normal)) return false;
+
+	if (!obj.face.texture.empty() && obj.face.texture.size() != obj.face.vertex.size()) return false;
+
+	if (!obj.face.normal.empty() && obj.face.normal.size() != obj.face.vertex.size()) return false;
+
+	auto inside = [](const obj::List<int>& list, const size_t count)
+	{
+		for (const auto index : list.v)
+			if (index < 0 || static_cast<size_t>(index) >= count) return false;
+		return true;
+	};
+
+	if (!inside(obj.face.vertex, obj.vertex.size()) || !inside(obj.face.texture, obj.texture.size()) || !inside(obj.face.normal, obj.normal.size())) return false;
+
+	if (!inside(obj.line.vertex, obj.vertex.size()) || !inside(obj.line.texture, obj.texture.size()) || !inside(obj.point.vertex, obj.vertex.size())) return false;
+
+	return true;
+}
+
+// libFuzzer entry, build with: clang++ -std=c++11 -g -O1 -fsanitize=fuzzer,address,undefined -DFUZZER fuzz/fuzz.cpp
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	const unsigned int option[] = { obj::standard, obj::standard | obj::lenient };
+
+	for (const bool triangulate : { false, true })
+	{
+		for (const auto options : option)
+		{
+			obj::Load obj(triangulate, options);
+
+			if (obj.load(reinterpret_cast<const char*>(data), size) && !consistent(obj))
+				abort();
+		}
+	}
+
+	return 0;
+}
+
+// Slow reference parser: stream based, strict, and only v, vt, vn and f
+struct Reference
+{
+	std::vector<std::vector<float>> vertex, texture, normal;
+	std::vector<std::vector<int>> faceVertex, faceTexture, faceNormal;
+
+	static bool number(const std::string& token, float& value)
+	{
+		char* end = nullptr;
+		value = ::strtof(token.c_str(), &end);
+		return !token.empty() && *end == '\0';
+	}
+
+	static bool index(const std::string& token, const size_t count, int& value)
+	{
+		if (token.empty()) return false;
+		char* end = nullptr;
+		const long parsed = strtol(token.c_str(), &end, 10);
+		if (*end != '\0' || parsed == 0) return false;
+		value = static_cast<int>(parsed > 0 ? parsed - 1 : static_cast<long>(count) + parsed);
+		return true;
+	}
+
+	bool load(const std::string& text)
+	{
+		std::string copy(text);
+
+		std::replace(copy.begin(), copy.end(), '\0', ' '); //Zero bytes are read as spaces
+
+		for (size_t at = copy.find("\\\n"); at != std::string::npos; at = copy.find("\\\n", at))
+			copy.replace(at, 2, "  "); //Line continuation
+
+		for (size_t at = copy.find("\\\r\n"); at != std::string::npos; at = copy.find("\\\r\n", at))
+			copy.replace(at, 3, "   ");
+
+		std::istringstream document(copy);
+		std::string row;
+
+		while (std::getline(document, row))
+		{
+			row = row.substr(0, row.find('\r')); //Carriage return ends a row
+
+			std::istringstream line(row);
+			std::string type, token;
+			std::vector<std::string> tokens;
+
+			line >> type;
+
+			while (line >> token) tokens.push_back(token);
+
+			if (type == "v" || type == "vt" || type == "vn")
+			{
+				std::vector<float> item(tokens.size());
+
+				for (size_t i = 0; i < tokens.size(); i++)
+					if (!number(tokens[i], item[i])) return false;
+
+				if (type == "v" && item.size() != 3 && item.size() != 4 && item.size() != 6) return false;
+				if (type == "vt" && (item.empty() || item.size() > 3)) return false;
+				if (type == "vn" && item.size() != 3) return false;
+
+				(type == "v" ? vertex : type == "vt" ? texture : normal).push_back(item);
+			}
+			else if (type == "f")
+			{
+				std::vector<int> v, t, n;
+
+				for (const auto& corner : tokens)
+				{
+					const auto first = corner.find('/');
+					const auto second = first == std::string::npos ? first : corner.find('/', first + 1);
+
+					int value;
+
+					if (!index(corner.substr(0, first), vertex.size(), value)) return false;
+					v.push_back(value);
+
+					if (first == std::string::npos) continue;
+
+					const auto vt = corner.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1);
+
+					if (vt.empty() && second == std::string::npos) return false; //"1/"
+
+					if (!vt.empty())
+					{
+						if (!index(vt, texture.size(), value)) return false;
+						t.push_back(value);
+					}
+
+					if (second == std::string::npos) continue;
+
+					if (!index(corner.substr(second + 1), normal.size(), value)) return false;
+					n.push_back(value);
+				}
+
+				if (v.size() < 3) return false;
+				if (!t.empty() && t.size() != v.size()) return false;
+				if (!n.empty() && n.size() != v.size()) return false;
+
+				faceVertex.push_back(v);
+				faceTexture.push_back(t);
+				faceNormal.push_back(n);
+			}
+		}
+
+		return valid(faceVertex, vertex.size()) && valid(faceTexture, texture.size()) && valid(faceNormal, normal.size());
+	}
+
+	static bool valid(const std::vector<std::vector<int>>& faces, const size_t count)
+	{
+		for (const auto& face : faces)
+			for (const auto index : face)
+				if (index < 0 || static_cast<size_t>(index) >= count) return false;
+
+		return true;
+	}
+};
+
+template<typename T>
+bool equal(const std::vector<std::vector<T>>& reference, const obj::List<T>& list)
+{
+	size_t item(0), offset(0);
+
+	for (const auto& values : reference)
+	{
+		if (item >= list.s.size() || static_cast<size_t>(list.s[item]) != values.size()) return false;
+
+		for (size_t i = 0; i < values.size(); i++)
+			if (list.v[offset + i] != values[i]) return false;
+
+		offset += values.size();
+
+		item++;
+	}
+
+	return item == list.s.size();
+}
+
+// Random but valid OBJ text, the mutator below breaks it afterwards
+std::string generate(std::mt19937& random)
+{
+	std::ostringstream text;
+
+	std::uniform_int_distribution<int> count(1, 20);
+	std::uniform_real_distribution<float> coordinate(-1000.0f, 1000.0f);
+
+	const int vertices = count(random);
+
+	for (int i = 0; i < vertices; i++)
+	{
+		text << "v " << coordinate(random) << " " << coordinate(random) << " " << coordinate(random) << "\n";
+		text << "vt " << coordinate(random) << " " << coordinate(random) << "\n";
+		text << "vn " << coordinate(random) << " " << coordinate(random) << " " << coordinate(random) << "\n";
+	}
+
+	const int faces = count(random);
+
+	for (int f = 0; f < faces; f++)
+	{
+		const int corners = 3 + random() % 4;
+		const int style = random() % 4; // v, v/vt, v//vn, v/vt/vn
+
+		text << "f";
+
+		for (int c = 0; c < corners; c++)
+		{
+			const int i = 1 + random() % vertices;
+			const int index = random() % 2 ? i : i - vertices - 1; // Positive or negative
+
+			text << " " << index;
+
+			if (style == 1) text << "/" << index;
+			if (style == 2) text << "//" << index;
+			if (style == 3) text << "/" << index << "/" << index;
+		}
+
+		text << "\n";
+	}
+
+	return text.str();
+}
+
+void mutate(std::string& text, std::mt19937& random)
+{
+	static const char bytes[] = { ' ', '\t', '/', '-', '+', '.', 'e', '0', '9', '\n', '\r', '\\', '#', 'x', '\0' };
+
+	const int mutations = random() % 4;
+
+	for (int m = 0; m < mutations && !text.empty(); m++)
+	{
+		const size_t at = random() % text.size();
+
+		switch (random() % 3)
+		{
+		case 0: text[at] = bytes[random() % sizeof(bytes)]; break;
+		case 1: text.insert(text.begin() + at, bytes[random() % sizeof(bytes)]); break;
+		case 2: text.erase(at, 1); break;
+		}
+	}
+}
+
+// Inputs the mutator does not reach, with the row their first error must be reported at
+struct Known
+{
+	const char* text;
+	size_t      row;
+};
+
+const Known known[] =
+{
+	{ "v 0 0 0\nf 1 1 9\nf", 2 },               // Bare f as the last row, nothing may be read past it
+	{ "v 0 0 0\nf\n1 1 1\nf 1 1 9\n", 4 },      // Bare f inside the file is not an element
+	{ "v 0 0 \\\n 0\nv 1 1 1\nf 1 2 x", 4 },    // Rows are lines in the file, also after a continuation
+	{ "v 0 0 \\\n 0\nv 1 1 1\nf 1 2 9", 4 },
+};
+
+#ifndef FUZZER
+int main(int argc, char* argv[])
+{
+	const int runs = argc > 1 ? atoi(argv[1]) : 100000;
+
+	std::mt19937 random(argc > 2 ? atoi(argv[2]) : 1);
+
+	int accepted(0), rejected(0), lenient(0), mismatch(0);
+
+	for (const auto& item : known)
+	{
+		const std::string text(item.text); //Exact size, so a read past the end is caught by the address sanitizer
+
+		LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+
+		obj::Load obj;
+
+		if (obj.load(text.data(), text.size()) || obj.error.row != item.row)
+		{
+			if (mismatch++ < 5)
+				std::cout << "Wrong error for:" << std::endl << text << std::endl << obj.error.message() << std::endl;
+		}
+	}
+
+	for (int run = 0; run < runs; run++)
+	{
+		std::string text = generate(random);
+
+		mutate(text, random);
+
+		LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+
+		Reference reference;
+
+		obj::Load obj;
+
+		const bool expected = reference.load(text);
+
+		const bool result = obj.load(text.data(), text.size());
+
+		if (!expected)
+		{
+			result ? lenient++ : rejected++; // Input is malformed, accepting it is reported but not an error
+
+			continue;
+		}
+
+		accepted++;
+
+		const bool same = result &&
+			equal(reference.vertex, obj.vertex) &&
+			equal(reference.texture, obj.texture) &&
+			equal(reference.normal, obj.normal) &&
+			equal(reference.faceVertex, obj.face.vertex) &&
+			equal(reference.faceTexture, obj.face.texture) &&
+			equal(reference.faceNormal, obj.face.normal);
+
+		if (same) continue;
+
+		if (mismatch++ < 5)
+			std::cout << "Mismatch in run " << run << ":" << std::endl << text << std::endl;
+	}
+
+	std::cout << "{ \"accepted\": " << accepted << ", \"rejected\": " << rejected
+			  << ", \"lenient\": " << lenient << ", \"mismatch\": " << mismatch << " }" << std::endl;
+
+	return mismatch ? 1 : 0;
+}
+#endif
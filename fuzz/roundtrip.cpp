@@ -0,0 +1,192 @@
+/*
+  Read, write and read again test of WavefrontOBJ.h
+
+  Build: g++ -std=c++11 -O1 -g -pthread -fsanitize=address,undefined fuzz/roundtrip.cpp -o roundtrip
+  Usage: roundtrip [runs] [seed] [locale]
+
+  Each run creates random OBJ text, loads it, writes it with obj::Save and loads the written file.
+  Every list must be equal after the second load. A locale such as de_DE.UTF-8 sets LC_NUMERIC first,
+  the written file must still use '.' as decimal point.
+ */
+
+#include "../WavefrontOBJ.h"
+#include <iostream>
+#include <sstream>
+#include <random>
+#include <cstdint>
+#include <clocale>
+
+// Any finite float, mostly by bit pattern so all exponents and denormals are covered
+float number(std::mt19937& random)
+{
+	if (random() % 4 == 0)
+		return static_cast<float>(static_cast<int>(random() % 20001) - 10000) / 1000.0f;
+
+	for (;;)
+	{
+		uint32_t bits = static_cast<uint32_t>(random());
+
+		float value;
+
+		memcpy(&value, &bits, sizeof(value));
+
+		if (std::isfinite(value))
+			return value;
+	}
+}
+
+std::string text(const float value)
+{
+	char buffer[32];
+
+	snprintf(buffer, sizeof(buffer), "%.9g", static_cast<double>(value));
+
+	for (char* c = buffer; *c; c++) //The locale may write another decimal point
+		if (*c != '-' && *c != '+' && *c != 'e' && (*c < '0' || *c > '9')) *c = '.';
+
+	return buffer;
+}
+
+std::string generate(std::mt19937& random)
+{
+	std::ostringstream obj;
+
+	const int vertices = 1 + static_cast<int>(random() % 20);
+
+	const bool texture = random() % 2 == 0;
+
+	const bool normal = random() % 2 == 0;
+
+	obj << "mtllib scene.mtl\n";
+
+	for (int i = 0; i < vertices; i++)
+	{
+		obj << "v " << text(number(random)) << " " << text(number(random)) << " " << text(number(random));
+
+		if (random() % 4 == 0)
+			obj << " " << text(number(random)) << " " << text(number(random)) << " " << text(number(random));
+
+		obj << "\n";
+
+		if (texture)
+			obj << "vt " << text(number(random)) << " " << text(number(random)) << "\n";
+
+		if (normal)
+			obj << "vn " << text(number(random)) << " " << text(number(random)) << " " << text(number(random)) << "\n";
+	}
+
+	if (random() % 4 == 0)
+		obj << "vp " << text(number(random)) << " " << text(number(random)) << "\n";
+
+	const int faces = static_cast<int>(random() % 20);
+
+	for (int i = 0; i < faces; i++)
+	{
+		switch (random() % 6)
+		{
+		case 0: obj << "usemtl material" << random() % 3 << "\n"; break;
+		case 1: obj << "o object" << random() % 3 << "\n"; break;
+		case 2: obj << "g group" << random() % 3 << "\n"; break;
+		case 3: obj << "s " << random() % 3 << "\n"; break;
+		case 4: obj << "# comment " << i << "\n"; break;
+		default: break;
+		}
+
+		const int corners = 3 + static_cast<int>(random() % 4);
+
+		obj << "f";
+
+		for (int c = 0; c < corners; c++)
+		{
+			const int index = 1 + static_cast<int>(random() % vertices);
+
+			obj << " " << index;
+
+			if (texture && normal) obj << "/" << index << "/" << index;
+			else if (texture) obj << "/" << index;
+			else if (normal) obj << "//" << index;
+		}
+
+		obj << "\n";
+	}
+
+	if (random() % 2 == 0)
+		obj << "l " << 1 + random() % vertices << " " << 1 + random() % vertices << "\n";
+
+	if (random() % 2 == 0)
+		obj << "p " << 1 + random() % vertices << "\n";
+
+	return obj.str();
+}
+
+template<typename T>
+bool equal(const obj::List<T>& a, const obj::List<T>& b)
+{
+	return a.v == b.v && a.s == b.s;
+}
+
+bool equal(obj::Load& a, obj::Load& b)
+{
+	if (!equal(a.vertex, b.vertex) || !equal(a.texture, b.texture) || !equal(a.normal, b.normal) || !equal(a.parameter, b.parameter)) return false;
+
+	if (!equal(a.face.vertex, b.face.vertex) || !equal(a.face.texture, b.face.texture) || !equal(a.face.normal, b.face.normal)) return false;
+
+	if (!equal(a.line.vertex, b.line.vertex) || !equal(a.line.texture, b.line.texture) || !equal(a.point.vertex, b.point.vertex)) return false;
+
+	return a.mtllib() == b.mtllib() && a.usemtl() == b.usemtl() && a.information() == b.information() && a.records() == b.records();
+}
+
+int main(int argc, char* argv[])
+{
+	const int runs = argc > 1 ? atoi(argv[1]) : 10000;
+
+	std::mt19937 random(argc > 2 ? atoi(argv[2]) : 1);
+
+	if (argc > 3 && setlocale(LC_NUMERIC, argv[3]) == nullptr)
+	{
+		std::cerr << "Locale " << argv[3] << " is not installed" << std::endl;
+
+		return 1;
+	}
+
+	const std::string path = "roundtrip.obj";
+
+	int failed(0);
+
+	for (int run = 0; run < runs; run++)
+	{
+		const std::string text = generate(random);
+
+		obj::Load read;
+
+		if (!read.load(text.data(), text.size()))
+		{
+			std::cerr << "Load failed: " << read.error.message() << std::endl << text << std::endl;
+
+			return 1;
+		}
+
+		obj::Save save(read);
+
+		if (!save.save(path))
+		{
+			std::cerr << "Save failed: " << path << std::endl;
+
+			return 1;
+		}
+
+		obj::Load again;
+
+		if (!again.load(path) || !equal(read, again))
+		{
+			if (failed++ == 0)
+				std::cerr << "Round trip differs:" << std::endl << text << std::endl;
+		}
+	}
+
+	remove(path.c_str());
+
+	std::cout << "{ \"runs\": " << runs << ", \"failed\": " << failed << " }" << std::endl;
+
+	return failed ? 1 : 0;
+}